@@ -0,0 +1,203 @@
+// ansi.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "ansi.h"
+
+
+// --- ANSI FUNCTIONS ---
+ANSI_TERM* InitAnsiTerm(int fd, int rows, int cols)
+{
+    ANSI_TERM* term = (ANSI_TERM*)malloc(sizeof(ANSI_TERM));
+    memset(term, 0, sizeof(ANSI_TERM));
+    term->fd = fd;
+    term->rows = rows;
+    term->cols = cols;
+    term->front = (CELL*)malloc((size_t)rows * cols * sizeof(CELL));
+    term->back = (CELL*)malloc((size_t)rows * cols * sizeof(CELL));
+    for (int i = 0; i < rows * cols; i++)
+    {
+        term->front[i].glyph = '\0';    // never drawn, so every cell differs
+        term->front[i].color = 0;
+        term->back[i].glyph = ' ';
+        term->back[i].color = 0;
+    }
+    for (int i = 0; i < ANSI_COLORS; i++)
+    {
+        SetAnsiColor(term, i, -1, -1);
+    }
+    term->capacity = (size_t)rows * cols * 2 + 64;
+    term->out = (char*)malloc(term->capacity);
+    term->cursorY = -1;
+    term->cursorX = -1;
+    term->color = -1;
+    return term;
+}
+
+void SetAnsiColor(ANSI_TERM* term, int color, int foreground, int background)
+{
+    term->foreground[color] = foreground < 0 ? 39 : 30 + foreground;
+    term->background[color] = background < 0 ? 49 : 40 + background;
+}
+
+void AnsiText(ANSI_TERM* term, int y, int x, const char* text, int length, int color)
+{
+    if (y < 0 || y >= term->rows)
+    {
+        return;
+    }
+    CELL* row = term->back + (size_t)y * term->cols;
+    for (int i = x < 0 ? -x : 0; i < length && x + i < term->cols && text[i] != '\0'; i++)
+    {
+        row[x + i].glyph = text[i];
+        row[x + i].color = (unsigned char)color;
+    }
+}
+
+void AnsiFill(ANSI_TERM* term, int y, int x, char glyph, int length, int color)
+{
+    if (y < 0 || y >= term->rows)
+    {
+        return;
+    }
+    CELL* row = term->back + (size_t)y * term->cols;
+    for (int i = x < 0 ? -x : 0; i < length && x + i < term->cols; i++)
+    {
+        row[x + i].glyph = glyph;
+        row[x + i].color = (unsigned char)color;
+    }
+}
+
+// Append to the escape stream - the buffer grows when a frame needs more
+void Emit(ANSI_TERM* term, size_t* used, const char* data, size_t length)
+{
+    if (*used + length > term->capacity)
+    {
+        term->capacity = (*used + length) * 2;
+        term->out = (char*)realloc(term->out, term->capacity);
+    }
+    memcpy(term->out + *used, data, length);
+    *used += length;
+}
+
+// Switch the terminal to the pair and character set of a cell - only the changed SGR parameters are sent
+void EmitColor(ANSI_TERM* term, size_t* used, int color)
+{
+    if (color == term->color)
+    {
+        return;
+    }
+    if (term->color < 0 || (color & ANSI_ACS) != (term->color & ANSI_ACS))
+    {
+        Emit(term, used, (color & ANSI_ACS) ? "\x1b(0" : "\x1b(B", 3);
+    }
+    int pair = (color & ~ANSI_ACS) % ANSI_COLORS;
+    int foreground = term->foreground[pair];
+    int background = term->background[pair];
+    char sgr[32];
+    if (term->color < 0)
+    {
+        Emit(term, used, sgr, snprintf(sgr, sizeof(sgr), "\x1b[0;%d;%dm", foreground, background));
+    }
+    else
+    {
+        int old = (term->color & ~ANSI_ACS) % ANSI_COLORS;
+        int fgChanged = foreground != term->foreground[old];
+        int bgChanged = background != term->background[old];
+        if (fgChanged && bgChanged)
+        {
+            Emit(term, used, sgr, snprintf(sgr, sizeof(sgr), "\x1b[%d;%dm", foreground, background));
+        }
+        else if (fgChanged || bgChanged)
+        {
+            Emit(term, used, sgr, snprintf(sgr, sizeof(sgr), "\x1b[%dm", fgChanged ? foreground : background));
+        }
+    }
+    term->color = color;
+}
+
+// Put the cursor at y, x - the cheapest of re-sending the cells in between, moving forward and an absolute move
+void EmitMove(ANSI_TERM* term, size_t* used, int y, int x)
+{
+    if (term->cursorY == y && term->cursorX == x)
+    {
+        return;
+    }
+    char move[32];
+    if (term->cursorY == y && term->cursorX >= 0 && x > term->cursorX)
+    {
+        CELL* row = term->front + (size_t)y * term->cols;
+        int gap = x - term->cursorX;
+        int resend = gap <= ANSI_MAX_SKIP;
+        for (int i = term->cursorX; resend && i < x; i++)
+        {
+            resend = row[i].color == term->color;
+        }
+        if (resend)
+        {
+            for (int i = term->cursorX; i < x; i++)
+            {
+                Emit(term, used, &row[i].glyph, 1);
+            }
+        }
+        else
+        {
+            Emit(term, used, move, snprintf(move, sizeof(move), "\x1b[%dC", gap));
+        }
+    }
+    else
+    {
+        Emit(term, used, move, snprintf(move, sizeof(move), "\x1b[%d;%dH", y + 1, x + 1));
+    }
+    term->cursorY = y;
+    term->cursorX = x;
+}
+
+void FlushAnsiTerm(ANSI_TERM* term)
+{
+    size_t used = 0;
+    for (int y = 0; y < term->rows; y++)
+    {
+        CELL* front = term->front + (size_t)y * term->cols;
+        CELL* back = term->back + (size_t)y * term->cols;
+        for (int x = 0; x < term->cols; x++)
+        {
+            if (front[x].glyph == back[x].glyph && front[x].color == back[x].color)
+            {
+                continue;
+            }
+            EmitMove(term, &used, y, x);
+            EmitColor(term, &used, back[x].color);
+            Emit(term, &used, &back[x].glyph, 1);
+            front[x] = back[x];
+            term->cursorX = x + 1 < term->cols ? x + 1 : -1;   // the cursor does not move past the last column
+        }
+    }
+
+    size_t written = 0;
+    while (written < used)
+    {
+        ssize_t n = write(term->fd, term->out + written, used - written);
+        term->writes++;
+        if (n < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            break;
+        }
+        written += n;
+    }
+    term->bytes += written;
+}
+
+void FreeAnsiTerm(ANSI_TERM* term)
+{
+    free(term->front);
+    free(term->back);
+    free(term->out);
+    free(term);
+}
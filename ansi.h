@@ -0,0 +1,44 @@
+// ansi.h
+#ifndef ANSI_H
+#define ANSI_H
+
+#define ANSI_COLORS 16          // color pairs the back end knows
+#define ANSI_ACS 0x80           // flag of CELL::color - the glyph is from the DEC line drawing set (box borders)
+#define ANSI_MAX_SKIP 4         // unchanged cells re-sent instead of moving the cursor over them
+
+// Character cell of the terminal
+typedef struct {
+    char glyph;
+    unsigned char color;        // color pair, ANSI_ACS for line drawing
+} CELL;
+
+// Direct ANSI terminal output - frames are drawn into the back buffer, diffed against the front buffer
+// (what the terminal shows) and sent as one escape stream in a single write()
+typedef struct {
+    int fd;
+    int rows, cols;
+    CELL* front;
+    CELL* back;
+    int foreground[ANSI_COLORS];    // SGR parameters of each color pair
+    int background[ANSI_COLORS];
+    char* out;                  // escape stream of the frame
+    size_t capacity;
+    int cursorY, cursorX;       // -1 when unknown
+    int color;                  // pair and line drawing state of the terminal, -1 when unknown
+    long bytes;                 // written in total
+    long writes;                // write syscalls in total
+} ANSI_TERM;
+
+// --- ANSI FUNCTIONS ---
+// Terminal of the given size on fd - the first flush repaints every cell
+ANSI_TERM* InitAnsiTerm(int fd, int rows, int cols);
+// Foreground and background of a color pair (ANSI color numbers, -1 for the terminal default)
+void SetAnsiColor(ANSI_TERM* term, int color, int foreground, int background);
+// Draw into the back buffer - clipped to the terminal
+void AnsiText(ANSI_TERM* term, int y, int x, const char* text, int length, int color);
+void AnsiFill(ANSI_TERM* term, int y, int x, char glyph, int length, int color);
+// Send the changed cells to the terminal
+void FlushAnsiTerm(ANSI_TERM* term);
+void FreeAnsiTerm(ANSI_TERM* term);
+
+#endif // ANSI_H
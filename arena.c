@@ -0,0 +1,86 @@
+// arena.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+
+
+// --- ARENA FUNCTIONS ---
+ARENA_BLOCK* NewArenaBlock(size_t size)
+{
+    ARENA_BLOCK* block = (ARENA_BLOCK*)malloc(sizeof(ARENA_BLOCK) + size + ARENA_ALIGN);
+    if (block == NULL)
+    {
+        fprintf(stderr, "Error allocating arena memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    block->next = NULL;
+    block->size = size + ARENA_ALIGN;   // room for aligning the first allocation
+    block->used = 0;
+    return block;
+}
+
+ARENA* InitArena(size_t size)
+{
+    ARENA* arena = (ARENA*)malloc(sizeof(ARENA));
+    arena->blocks = NewArenaBlock(size);
+    arena->allocated = 0;
+    arena->allocations = 0;
+    return arena;
+}
+
+void* ArenaAlloc(ARENA* arena, size_t size)
+{
+    ARENA_BLOCK* block = arena->blocks;
+    uintptr_t start = ((uintptr_t)(block->data + block->used) + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    if (start + size > (uintptr_t)(block->data + block->size))
+    {
+        ARENA_BLOCK* grown = NewArenaBlock(size > block->size ? size : block->size);  // at least doubles the arena
+        grown->next = block;
+        arena->blocks = block = grown;
+        start = ((uintptr_t)block->data + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    }
+    block->used = start + size - (uintptr_t)block->data;
+    arena->allocated += size;
+    arena->allocations++;
+    return (void*)start;
+}
+
+void* ArenaCalloc(ARENA* arena, size_t count, size_t size)
+{
+    void* memory = ArenaAlloc(arena, count * size);
+    memset(memory, 0, count * size);
+    return memory;
+}
+
+void ResetArena(ARENA* arena)
+{
+    if (arena->blocks->next != NULL)
+    {
+        size_t total = 0;
+        ARENA_BLOCK* block = arena->blocks;
+        while (block != NULL)
+        {
+            ARENA_BLOCK* next = block->next;
+            total += block->size;
+            free(block);
+            block = next;
+        }
+        arena->blocks = NewArenaBlock(total);
+    }
+    arena->blocks->used = 0;
+    arena->allocated = 0;
+}
+
+void FreeArena(ARENA* arena)
+{
+    ARENA_BLOCK* block = arena->blocks;
+    while (block != NULL)
+    {
+        ARENA_BLOCK* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,33 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGN 32  // every allocation is aligned for AVX2 loads
+
+// Block of arena memory - blocks are only chained when the first one runs out
+typedef struct ARENA_BLOCK {
+    struct ARENA_BLOCK* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ARENA_BLOCK;
+
+// Arena - bump allocator for everything with the lifetime of a game session
+typedef struct {
+    ARENA_BLOCK* blocks;
+    size_t allocated;   // bytes handed out since the last reset
+    long allocations;   // allocations since the arena was created
+} ARENA;
+
+// --- ARENA FUNCTIONS ---
+ARENA* InitArena(size_t size);
+// Aligned, uninitialized memory - never NULL, the arena grows when needed
+void* ArenaAlloc(ARENA* arena, size_t size);
+void* ArenaCalloc(ARENA* arena, size_t count, size_t size);
+// Release everything at once - a grown arena is merged into a single block, so the next session fits without growing
+void ResetArena(ARENA* arena);
+void FreeArena(ARENA* arena);
+
+#endif // ARENA_H
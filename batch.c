@@ -0,0 +1,332 @@
+// batch.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "batch.h"
+
+// Sweep file keys, in SweepSetting order
+const char* SWEEP_KEYS[SWEEP_SETTINGS] = { "N_CARS", "CAR_MOVE_FACTOR", "FROG_MOVE_FACTOR", "COLS", "PLAYABLE_ROWS" };
+
+
+// --- SWEEP FUNCTIONS ---
+// Parse V1,V2,... or FROM..TO - number of values, -1 on error
+int ParseSweepValues(const char* text, int* values)
+{
+    int from, to, length;
+    if (sscanf(text, "%d..%d%n", &from, &to, &length) == 2 && text[length] == '\0')
+    {
+        if (from < 1 || to < from || to - from >= BATCH_MAX_VALUES)
+        {
+            return -1;
+        }
+        for (int i = 0; i <= to - from; i++)
+        {
+            values[i] = from + i;
+        }
+        return to - from + 1;
+    }
+    int count = 0;
+    while (*text)
+    {
+        if (count == BATCH_MAX_VALUES || sscanf(text, "%d%n", &values[count], &length) != 1 || values[count] < 1)
+        {
+            return -1;
+        }
+        count++;
+        text += length;
+        if (*text == ',')
+        {
+            text++;
+        }
+        else if (*text)
+        {
+            return -1;
+        }
+    }
+    return count;
+}
+
+// Check the values of a sweep setting against the range of the settings file (and the frog of the base config) - 0 if they fit
+int CheckSweepValues(SWEEP* sweep, CFG* base, int setting, const char* filename, int lineNo, FILE* err)
+{
+    const CFG_SETTING* range = FindCfgSetting(SWEEP_KEYS[setting]);
+    int min = range->min;
+    min = setting == SWEEP_COLS && base->frog->width + 2 > min ? base->frog->width + 2 : min;   // the frog and its border
+    min = setting == SWEEP_PLAYABLE_ROWS && base->frog->height + 2 > min ? base->frog->height + 2 : min;
+    for (int i = 0; i < sweep->nValues[setting]; i++)
+    {
+        if (sweep->values[setting][i] < min || sweep->values[setting][i] > range->max)
+        {
+            fprintf(err, "%s:%d: %s must be between %d and %d, got %d\n", filename, lineNo, SWEEP_KEYS[setting], min, range->max,
+                sweep->values[setting][i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int LoadSweep(SWEEP* sweep, CFG* base, const char* filename, FILE* err)
+{
+    int defaults[SWEEP_SETTINGS] = { base->cars->nCars, base->cars->moveFactor, base->frog->moveFactor, base->area->cols, base->area->playableRows };
+    for (int i = 0; i < SWEEP_SETTINGS; i++)
+    {
+        sweep->values[i][0] = defaults[i];
+        sweep->nValues[i] = 1;
+    }
+
+    FILE* file = fopen(filename, "r");
+    if (!file)
+    {
+        fprintf(err, "%s: cannot open the sweep file\n", filename);
+        return -1;
+    }
+    char line[1024];
+    int lineNo = 0;
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), file))
+    {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+        char* value = strchr(line, '=');
+        int setting = SWEEP_SETTINGS;
+        if (value)
+        {
+            *value++ = '\0';
+            for (setting = 0; setting < SWEEP_SETTINGS && strcmp(line, SWEEP_KEYS[setting]) != 0; setting++);
+        }
+        if (setting == SWEEP_SETTINGS)
+        {
+            fprintf(err, "%s:%d: expected one of N_CARS, CAR_MOVE_FACTOR, FROG_MOVE_FACTOR, COLS, PLAYABLE_ROWS followed by '='\n", filename, lineNo);
+            status = -1;
+        }
+        else if ((sweep->nValues[setting] = ParseSweepValues(value, sweep->values[setting])) <= 0)
+        {
+            fprintf(err, "%s:%d: expected positive values V1,V2,... or FROM..TO (at most %d)\n", filename, lineNo, BATCH_MAX_VALUES);
+            status = -1;
+        }
+        else
+        {
+            status = CheckSweepValues(sweep, base, setting, filename, lineNo, err);
+        }
+    }
+    fclose(file);
+    return status;
+}
+
+
+// --- WORK STEALING ---
+uint64_t PackRange(uint32_t next, uint32_t end)
+{
+    return ((uint64_t)end << 32) | next;
+}
+
+// Take the next task of the worker's own range - -1 if it is empty
+int PopTask(TASK_RANGE* own)
+{
+    uint64_t range = atomic_load(&own->range);
+    while (1)
+    {
+        uint32_t next = (uint32_t)range;
+        uint32_t end = (uint32_t)(range >> 32);
+        if (next >= end)
+        {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak(&own->range, &range, PackRange(next + 1, end)))
+        {
+            return (int)next;
+        }
+    }
+}
+
+// Move the back half of another worker's range to the (empty) own range - 0 if every range is empty
+int StealTasks(BATCH* batch, int id)
+{
+    for (int i = 1; i < batch->nWorkers; i++)
+    {
+        TASK_RANGE* victim = &batch->ranges[(id + i) % batch->nWorkers];
+        uint64_t range = atomic_load(&victim->range);
+        while (1)
+        {
+            uint32_t next = (uint32_t)range;
+            uint32_t end = (uint32_t)(range >> 32);
+            if (next >= end)
+            {
+                break;
+            }
+            uint32_t split = end - (end - next + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &range, PackRange(next, split)))
+            {
+                atomic_store(&batch->ranges[id].range, PackRange(split, end));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void RunTask(BATCH_WORKER* worker, int task)
+{
+    BATCH* batch = worker->batch;
+    int point = task / batch->chunks;
+    int first = (task % batch->chunks) * BATCH_CHUNK;
+    int last = first + BATCH_CHUNK < batch->games ? first + BATCH_CHUNK : batch->games;
+    for (int i = first; i < last; i++)
+    {
+        PlayHeadlessGame(&batch->points[point].cfg, batch->sprites, worker->arena, DeriveSeed(batch->seed, i), &worker->stats[point]);
+    }
+}
+
+void* RunWorker(void* arg)
+{
+    BATCH_WORKER* worker = (BATCH_WORKER*)arg;
+    TASK_RANGE* own = &worker->batch->ranges[worker->id];
+    while (1)
+    {
+        int task = PopTask(own);
+        if (task < 0)
+        {
+            if (!StealTasks(worker->batch, worker->id))
+            {
+                break;  // tasks only move from range to range, so an empty round means the batch is done
+            }
+            continue;
+        }
+        RunTask(worker, task);
+    }
+    return NULL;
+}
+
+
+// --- BATCH FUNCTIONS ---
+// Apply the i-th combination of the sweep to a copy of the base config
+void InitBatchPoint(BATCH_POINT* point, CFG* base, SWEEP* sweep, int i)
+{
+    memset(point, 0, sizeof(BATCH_POINT));
+    for (int s = SWEEP_SETTINGS - 1; s >= 0; s--)
+    {
+        point->settings[s] = sweep->values[s][i % sweep->nValues[s]];
+        i /= sweep->nValues[s];
+    }
+    point->cfg = *base;
+    point->area = *base->area;
+    point->frog = *base->frog;  // shapes are shared with the base config
+    point->cars = *base->cars;
+    point->cfg.area = &point->area;
+    point->cfg.frog = &point->frog;
+    point->cfg.cars = &point->cars;
+    point->cars.nCars = point->settings[SWEEP_N_CARS];
+    point->cars.moveFactor = point->settings[SWEEP_CAR_MOVE_FACTOR];
+    point->frog.moveFactor = point->settings[SWEEP_FROG_MOVE_FACTOR];
+    point->area.cols = point->settings[SWEEP_COLS];
+    point->area.playableRows = point->settings[SWEEP_PLAYABLE_ROWS];
+}
+
+BATCH* RunBatch(CFG* base, SWEEP* sweep, int games, uint64_t seed, int workers)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    BATCH* batch = (BATCH*)malloc(sizeof(BATCH));
+    batch->nPoints = 1;
+    for (int s = 0; s < SWEEP_SETTINGS; s++)
+    {
+        batch->nPoints *= sweep->nValues[s];
+    }
+    batch->points = (BATCH_POINT*)malloc(batch->nPoints * sizeof(BATCH_POINT));
+    size_t arenaSize = 0;
+    for (int i = 0; i < batch->nPoints; i++)
+    {
+        InitBatchPoint(&batch->points[i], base, sweep, i);
+        size_t size = SimArenaSize(&batch->points[i].cfg);
+        arenaSize = size > arenaSize ? size : arenaSize;
+    }
+    batch->games = games;
+    batch->chunks = (games + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    batch->seed = seed;
+    batch->sprites = InitSpriteAtlas(base);
+    batch->nWorkers = workers;
+
+    // deal the tasks out in equal ranges, stealing evens out the rest
+    int tasks = batch->nPoints * batch->chunks;
+    batch->ranges = (TASK_RANGE*)aligned_alloc(64, workers * sizeof(TASK_RANGE));
+    BATCH_WORKER* pool = (BATCH_WORKER*)malloc(workers * sizeof(BATCH_WORKER));
+    pthread_t* threads = (pthread_t*)malloc(workers * sizeof(pthread_t));
+    for (int i = 0; i < workers; i++)
+    {
+        atomic_init(&batch->ranges[i].range, PackRange((uint32_t)((long)tasks * i / workers), (uint32_t)((long)tasks * (i + 1) / workers)));
+        pool[i].batch = batch;
+        pool[i].id = i;
+        pool[i].arena = InitArena(arenaSize);
+        pool[i].stats = (HEADLESS_STATS*)calloc(batch->nPoints, sizeof(HEADLESS_STATS));
+    }
+    for (int i = 1; i < workers; i++)
+    {
+        pthread_create(&threads[i], NULL, RunWorker, &pool[i]);
+    }
+    RunWorker(&pool[0]);    // the calling thread is worker 0
+
+    for (int i = 0; i < workers; i++)
+    {
+        if (i > 0)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        for (int p = 0; p < batch->nPoints; p++)
+        {
+            HEADLESS_STATS* from = &pool[i].stats[p];
+            HEADLESS_STATS* to = &batch->points[p].stats;
+            to->games += from->games;
+            for (int r = 0; r <= INTERRUPTED; r++)
+            {
+                to->results[r] += from->results[r];
+            }
+            to->frames += from->frames;
+            to->successFrames += from->successFrames;
+            to->distance += from->distance;
+        }
+        FreeArena(pool[i].arena);
+        free(pool[i].stats);
+    }
+    free(threads);
+    free(pool);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    batch->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return batch;
+}
+
+void PrintBatchCsv(BATCH* batch, FILE* out)
+{
+    fprintf(out, "n_cars,car_move_factor,frog_move_factor,cols,playable_rows,games,success,failure,time_over,"
+        "success_rate,failure_rate,time_over_rate,frames_per_game,frames_to_finish\n");
+    for (int i = 0; i < batch->nPoints; i++)
+    {
+        BATCH_POINT* point = &batch->points[i];
+        HEADLESS_STATS* stats = &point->stats;
+        double games = stats->games > 0 ? stats->games : 1;
+        fprintf(out, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.1f,",
+            point->settings[SWEEP_N_CARS], point->settings[SWEEP_CAR_MOVE_FACTOR], point->settings[SWEEP_FROG_MOVE_FACTOR],
+            point->settings[SWEEP_COLS], point->settings[SWEEP_PLAYABLE_ROWS], stats->games,
+            stats->results[SUCCESS], stats->results[FAILURE], stats->results[TIME_OVER],
+            stats->results[SUCCESS] / games, stats->results[FAILURE] / games, stats->results[TIME_OVER] / games,
+            stats->frames / games);
+        if (stats->results[SUCCESS] > 0)
+        {
+            fprintf(out, "%.1f", (double)stats->successFrames / stats->results[SUCCESS]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void FreeBatch(BATCH* batch)
+{
+    FreeSpriteAtlas(batch->sprites);
+    free(batch->ranges);
+    free(batch->points);
+    free(batch);
+}
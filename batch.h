@@ -0,0 +1,75 @@
+// batch.h
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdatomic.h>
+#include "headless.h"
+
+#define BATCH_CHUNK 256         // games per task - large enough to hide the scheduling cost
+#define BATCH_MAX_VALUES 64     // values per swept setting
+
+// Settings that can be swept
+typedef enum {
+    SWEEP_N_CARS,
+    SWEEP_CAR_MOVE_FACTOR,
+    SWEEP_FROG_MOVE_FACTOR,
+    SWEEP_COLS,
+    SWEEP_PLAYABLE_ROWS,
+    SWEEP_SETTINGS
+} SweepSetting;
+
+// Parameter sweep - every combination of the listed values is one point of the batch
+typedef struct {
+    int values[SWEEP_SETTINGS][BATCH_MAX_VALUES];
+    int nValues[SWEEP_SETTINGS];
+} SWEEP;
+
+// Results of one combination of settings
+typedef struct {
+    int settings[SWEEP_SETTINGS];
+    CFG cfg;                    // the base config with the settings applied
+    AREA_CFG area;
+    FROG_CFG frog;
+    CARS_CFG cars;
+    HEADLESS_STATS stats;
+} BATCH_POINT;
+
+// Range of tasks owned by a worker - next task in the low 32 bits, end in the high 32 bits,
+// so that the owner (from the front) and thieves (from the back) can both take tasks with a single CAS
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;
+} TASK_RANGE;
+
+// Batch of headless games spread over a work-stealing thread pool
+typedef struct {
+    BATCH_POINT* points;
+    int nPoints;
+    int games;                  // games per point
+    int chunks;                 // tasks per point
+    uint64_t seed;
+    SPRITE_ATLAS* sprites;      // shared, read-only
+    int nWorkers;
+    TASK_RANGE* ranges;         // one per worker
+    double seconds;
+} BATCH;
+
+// Worker of the pool - owns its arena and its statistics, nothing is shared while playing
+typedef struct {
+    BATCH* batch;
+    int id;
+    ARENA* arena;
+    HEADLESS_STATS* stats;      // one per point
+} BATCH_WORKER;
+
+// --- SWEEP FUNCTIONS ---
+// Read a sweep file - lines KEY=V1,V2,... or KEY=FROM..TO, settings that are not listed keep the base config value
+// 0 on success, -1 on error (reported to err with the line number)
+int LoadSweep(SWEEP* sweep, CFG* base, const char* filename, FILE* err);
+
+// --- BATCH FUNCTIONS ---
+// Play the given number of games for every point of the sweep - game i of every point is seeded with DeriveSeed(seed, i)
+BATCH* RunBatch(CFG* base, SWEEP* sweep, int games, uint64_t seed, int workers);
+void PrintBatchCsv(BATCH* batch, FILE* out);
+void FreeBatch(BATCH* batch);
+
+#endif // BATCH_H
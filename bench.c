@@ -0,0 +1,354 @@
+// bench.c
+#include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "bench.h"
+#include "pacer.h"
+
+#define BENCH_INITIAL_TIME 1000000  // seconds - benchmarked games do not run out of time
+
+// Scale presets - from the default game up to lanes far larger than any screen
+const BENCH_PRESET BENCH_PRESETS[] = {
+    { "default", 0, 0 },
+    { "medium", 1000, 400 },
+    { "large", 10000, 1000 },
+    { "huge", 100000, 4000 },
+};
+const int N_BENCH_PRESETS = sizeof(BENCH_PRESETS) / sizeof(BENCH_PRESET);
+
+
+// --- ALLOCATION COUNTING ---
+// Bytes of heap in use, from glibc's allocator statistics (0 elsewhere) - the allocator itself is not wrapped
+long HeapInUse()
+{
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    return (long)(info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+
+// --- BENCHMARKS ---
+void BenchMoveObj(BENCH* bench, long ops)
+{
+    OBJ frog = *bench->sim->frog;
+    for (long i = 0; i < ops; i++)
+    {
+        MoveObj(&frog, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+    }
+    bench->sink += frog.x + frog.y;
+}
+
+void BenchCollision(BENCH* bench, long ops)
+{
+    CAR_POOL* cars = bench->sim->cars;
+    OBJ frog = *bench->sim->frog;
+    OBJ car = frog;
+    car.width = cars->width;
+    car.height = cars->height;
+    car.y = frog.y;
+    for (long i = 0; i < ops; i++)
+    {
+        car.x = (int)(i % bench->sim->cols);
+        bench->sink += Collision(&frog, &car);
+    }
+}
+
+// Same sweep as Collision, with the sprites of the frog and the car
+void BenchSpritesOverlap(BENCH* bench, long ops)
+{
+    SIM* sim = bench->sim;
+    SPRITE* frog = GetSprite(bench->sprites, sim->frog->sprite);
+    SPRITE* car = GetSprite(bench->sprites, bench->sprites->car);
+    for (long i = 0; i < ops; i++)
+    {
+        bench->sink += SpritesOverlap(frog, sim->frog->x, sim->frog->y, car, (int)(i % sim->cols), sim->frog->y);
+    }
+}
+
+void BenchUpdateCars(BENCH* bench, long ops)
+{
+    CAR_POOL* cars = bench->sim->cars;
+    SetEagerCars(cars, 0, bench->sim->rows);    // every car, as without a view
+    for (long i = 0; i < ops; i++)
+    {
+        UpdateCars(cars);
+    }
+    bench->sink += cars->x[0];
+}
+
+// Query boxes walk over all lanes
+void BenchCollideCars(BENCH* bench, long ops)
+{
+    CAR_POOL* cars = bench->sim->cars;
+    OBJ* frog = bench->sim->frog;
+    for (long i = 0; i < ops; i++)
+    {
+        int y = (int)(i % bench->sim->rows);
+        bench->sink += CollideCars(cars, frog->x, y, frog->width, frog->height);
+    }
+}
+
+void BenchCollideLanes(BENCH* bench, long ops)
+{
+    SIM* sim = bench->sim;
+    for (long i = 0; i < ops; i++)
+    {
+        int y = (int)(i % sim->rows);
+        bench->sink += CollideLanes(sim->lanes, sim->cars, sim->frog->x, y, sim->frog->width, sim->frog->height);
+    }
+}
+
+void BenchCollideSprites(BENCH* bench, long ops)
+{
+    SIM* sim = bench->sim;
+    SPRITE* frog = GetSprite(sim->sprites, sim->frog->sprite);
+    for (long i = 0; i < ops; i++)
+    {
+        int y = (int)(i % sim->rows);
+        bench->sink += CollideSprites(sim->lanes, sim->cars, sim->sprites, frog, sim->frog->x, y);
+    }
+}
+
+void BenchPrintSprite(BENCH* bench, long ops)
+{
+    SPRITE* sprite = GetSprite(bench->sprites, bench->sim->cars->sprite[0]);
+    int xs = bench->playable.cols - sprite->width - 1;
+    int ys = bench->playable.rows - sprite->height - 1;
+    for (long i = 0; i < ops; i++)
+    {
+        PrintSprite(&bench->playable, sprite, 1 + (int)(i % xs), 1 + (int)((i / xs) % ys), COLOR_CAR);
+    }
+}
+
+// One frame of Play() without the wait - input, step and render
+void BenchFrame(BENCH* bench, long ops)
+{
+    for (long i = 0; i < ops; i++)
+    {
+        int key = wgetch(bench->status.window);
+        StepSim(bench->sim, key == ERR ? NO_KEY : key);
+        RenderFrame(bench->renderer, bench->sim);
+    }
+    bench->sink += bench->sim->timer->frameNo;
+}
+
+const BENCHMARK BENCHMARKS[] = {
+    { "MoveObj", 0, 0, 0, BenchMoveObj },
+    { "Collision", 0, 0, 0, BenchCollision },
+    { "SpritesOverlap", 0, 0, 0, BenchSpritesOverlap },
+    { "UpdateCars", 1, 0, 0, BenchUpdateCars },
+    { "CollideCars", 1, 0, 0, BenchCollideCars },
+    { "CollideLanes", 0, 0, 0, BenchCollideLanes },
+    { "CollideSprites", 0, 0, 0, BenchCollideSprites },
+    { "PrintSprite", 0, 1, 0, BenchPrintSprite },
+    { "Frame", 0, 1, 0, BenchFrame },
+    { "PrintSpriteAnsi", 0, 1, 1, BenchPrintSprite },
+    { "FrameAnsi", 0, 1, 1, BenchFrame },
+};
+const int N_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARK);
+
+
+// --- BENCH FUNCTIONS ---
+// Apply the preset to a copy of the base config - one lane per car, the frog starts below the last one
+void InitBench(BENCH* bench, CFG* base, const BENCH_PRESET* preset)
+{
+    memset(bench, 0, sizeof(BENCH));
+    bench->preset = preset;
+    bench->cfg = *base;
+    bench->timing = *base->timing;
+    bench->area = *base->area;
+    bench->cars = *base->cars;  // shapes are shared with the base config
+    bench->cfg.timing = &bench->timing;
+    bench->cfg.area = &bench->area;
+    bench->cfg.cars = &bench->cars;
+    bench->timing.initialTime = BENCH_INITIAL_TIME;
+    if (preset->nCars > 0)
+    {
+        bench->cars.nCars = preset->nCars;
+        bench->area.playableRows = preset->nCars * (base->cars->height + base->frog->height) + 2 * base->frog->height + 4;
+    }
+    if (preset->cols > 0)
+    {
+        bench->area.cols = preset->cols;
+    }
+    bench->sprites = InitSpriteAtlas(&bench->cfg);
+    bench->arena = InitArena(SimArenaSize(&bench->cfg));
+}
+
+// Terminal of the preset's size on /dev/null - NULL if there is no terminal description to draw with
+SCREEN* OpenBenchScreen(BENCH* bench, FILE* null)
+{
+    int rows = bench->area.playableRows < BENCH_SCREEN_ROWS ? bench->area.playableRows : BENCH_SCREEN_ROWS;
+    char text[16];
+    snprintf(text, sizeof(text), "%d", rows + bench->area.statusRows);
+    setenv("LINES", text, 1);
+    snprintf(text, sizeof(text), "%d", bench->area.cols);
+    setenv("COLUMNS", text, 1);
+    SCREEN* screen = newterm("xterm-256color", null, null);
+    screen = screen ? screen : newterm("xterm", null, null);
+    if (!screen)
+    {
+        return NULL;
+    }
+    InitColors();
+    WIN* wins[2] = { &bench->playable, &bench->status };
+    for (int i = 0; i < 2; i++)
+    {
+        WIN* win = wins[i];
+        win->rows = i == 0 ? rows : bench->area.statusRows;
+        win->cols = bench->area.cols;
+        win->x = 0;
+        win->y = i == 0 ? 0 : rows;
+        win->color = i == 0 ? COLOR_PLAYABLE : COLOR_STATUS;
+        win->window = subwin(stdscr, win->rows, win->cols, win->y, win->x);
+        CleanWin(win);
+    }
+    nodelay(bench->status.window, TRUE);
+    bench->nullFd = fileno(null);
+    return screen;
+}
+
+void CloseBenchScreen(BENCH* bench)
+{
+    delwin(bench->playable.window);
+    delwin(bench->status.window);
+    endwin();
+    delscreen(bench->screen);
+    bench->screen = NULL;
+}
+
+// Fresh game for every benchmark, drawn from scratch when the benchmark draws
+void SetupBenchmark(BENCH* bench, const BENCHMARK* benchmark)
+{
+    ResetArena(bench->arena);
+    bench->sim = InitSim(&bench->cfg, bench->sprites, 1, bench->arena);
+    if (benchmark->ansi)
+    {
+        bench->ansi = InitAnsiTerm(bench->nullFd, bench->playable.rows + bench->status.rows, bench->playable.cols);
+        InitAnsiColors(bench->ansi);
+        bench->playable.ansi = bench->ansi;
+        bench->status.ansi = bench->ansi;
+        CleanWin(&bench->status);
+    }
+    if (benchmark->terminal)
+    {
+        CleanWin(&bench->playable);
+        bench->renderer = InitRenderer(&bench->playable, &bench->status, bench->sim);
+    }
+}
+
+void TeardownBenchmark(BENCH* bench)
+{
+    if (bench->renderer)
+    {
+        FreeRenderer(bench->renderer);
+        bench->renderer = NULL;
+    }
+    if (bench->ansi)
+    {
+        FreeAnsiTerm(bench->ansi);
+        bench->ansi = NULL;
+        bench->playable.ansi = NULL;
+        bench->status.ansi = NULL;
+    }
+}
+
+// Run with doubling ops until a run takes BENCH_MIN_NS, then report the last run as a JSON object
+void MeasureBenchmark(BENCH* bench, const BENCHMARK* benchmark, int first, FILE* out)
+{
+    SetupBenchmark(bench, benchmark);
+    benchmark->run(bench, 1);   // warm-up
+    long ops = 1;
+    int64_t elapsed = 0;
+    long allocations = 0;
+    long heapBytes = 0;
+    while (elapsed < BENCH_MIN_NS)
+    {
+        ops *= 2;
+        long before = bench->arena->allocations;
+        long heapBefore = HeapInUse();
+        int64_t start = NowNs();
+        benchmark->run(bench, ops);
+        elapsed = NowNs() - start;
+        allocations = bench->arena->allocations - before;
+        heapBytes = HeapInUse() - heapBefore;   // what the run left allocated on the heap
+    }
+    TeardownBenchmark(bench);
+
+    int items = benchmark->perCar ? bench->cars.nCars : 1;
+    double nsPerOp = (double)elapsed / ops;
+    fprintf(out, "%s\n        { \"benchmark\": \"%s\", \"ops\": %ld, \"ns_per_op\": %.2f, \"ops_per_s\": %.1f, "
+        "\"items_per_op\": %d, \"ns_per_item\": %.3f, \"allocs_per_op\": %.3f, \"heap_bytes_per_op\": %.3f }",
+        first ? "" : ",", benchmark->name, ops, nsPerOp, 1e9 / nsPerOp, items, nsPerOp / (items > 0 ? items : 1),
+        (double)allocations / ops, (double)heapBytes / ops);
+}
+
+void RunPreset(CFG* base, const BENCH_PRESET* preset, int first, FILE* null, FILE* out, FILE* err)
+{
+    BENCH bench;
+    InitBench(&bench, base, preset);
+    bench.screen = OpenBenchScreen(&bench, null);
+    fprintf(out, "%s\n    { \"preset\": \"%s\", \"cars\": %d, \"rows\": %d, \"cols\": %d, \"screen_rows\": %d, \"results\": [",
+        first ? "" : ",", preset->name, bench.cars.nCars, bench.area.playableRows, bench.area.cols,
+        bench.screen ? bench.playable.rows : 0);
+    int printed = 0;
+    for (int i = 0; i < N_BENCHMARKS; i++)
+    {
+        if (BENCHMARKS[i].terminal && !bench.screen)
+        {
+            continue;
+        }
+        fprintf(err, "bench: %s %s\n", preset->name, BENCHMARKS[i].name);
+        MeasureBenchmark(&bench, &BENCHMARKS[i], printed++ == 0, out);
+    }
+    fprintf(out, "\n    ] }");
+    if (bench.screen)
+    {
+        CloseBenchScreen(&bench);
+    }
+    else
+    {
+        fprintf(err, "bench: no terminal description, %s skips rendering\n", preset->name);
+    }
+    FreeArena(bench.arena);
+    FreeSpriteAtlas(bench.sprites);
+}
+
+int RunBench(CFG* base, const char* preset, FILE* out, FILE* err)
+{
+    int selected = -1;
+    for (int i = 0; preset && i < N_BENCH_PRESETS; i++)
+    {
+        selected = strcmp(preset, BENCH_PRESETS[i].name) == 0 ? i : selected;
+    }
+    if (preset && selected < 0)
+    {
+        fprintf(err, "bench: unknown preset %s (default, medium, large, huge)\n", preset);
+        return -1;
+    }
+    FILE* null = fopen("/dev/null", "r+");
+    if (!null)
+    {
+        fprintf(err, "bench: cannot open /dev/null\n");
+        return -1;
+    }
+
+    fprintf(out, "{\n  \"kernels\": \"%s\",\n  \"presets\": [", CarKernelName());
+    int first = 1;
+    for (int i = 0; i < N_BENCH_PRESETS; i++)
+    {
+        if (selected < 0 || selected == i)
+        {
+            RunPreset(base, &BENCH_PRESETS[i], first, null, out, err);
+            first = 0;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(null);
+    return 0;
+}
@@ -0,0 +1,50 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "render.h"
+
+#define BENCH_MIN_NS 200000000L     // every benchmark runs at least this long (doubling the ops until it does)
+#define BENCH_SCREEN_ROWS 200       // rows of the playable window of the rendering benchmarks, a camera over larger worlds
+
+// Scale of a benchmark run - 0 keeps the base config value, rows are fitted to the cars when 0
+typedef struct {
+    const char* name;
+    int nCars;
+    int cols;
+} BENCH_PRESET;
+
+// Benchmarked game - a copy of the base config with the preset applied, rendered to a terminal on /dev/null
+typedef struct {
+    const BENCH_PRESET* preset;
+    CFG cfg;
+    TIMING_CFG timing;
+    AREA_CFG area;
+    CARS_CFG cars;
+    SPRITE_ATLAS* sprites;
+    ARENA* arena;
+    SIM* sim;
+    SCREEN* screen;             // NULL if no terminal description was found - rendering is skipped
+    WIN playable;
+    WIN status;
+    int nullFd;                 // output of the ANSI back end
+    ANSI_TERM* ansi;
+    RENDERER* renderer;
+    long sink;                  // results of the measured calls end up here, so they are not optimized away
+} BENCH;
+
+// Measured function - ops calls of the benchmarked code
+typedef struct {
+    const char* name;
+    int perCar;                 // 1 if one op handles every car
+    int terminal;               // 1 if it draws
+    int ansi;                   // 1 to draw with the ANSI back end instead of ncurses
+    void (*run)(BENCH* bench, long ops);
+} BENCHMARK;
+
+// --- BENCH FUNCTIONS ---
+// Run every benchmark for the named preset (all presets for NULL) - JSON on out, progress on err
+// 0 on success, -1 for an unknown preset
+int RunBench(CFG* base, const char* preset, FILE* out, FILE* err);
+
+#endif // BENCH_H
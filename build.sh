@@ -1,11 +1,29 @@
 #!/bin/bash
 
 # Utility script for compiling the program to uniquely identified executables
+# --lib builds the vectorized environment (env.h) as a shared library instead - no terminal code in it
+# --test builds and runs every program in tests/ - the game without its main
+
+if [ "$1" == "--lib" ]; then
+    OUTPUT_FILE="./builds/libfrogenv_$(date +%s%N).so"
+    gcc -O2 -fPIC -shared env.c sim.c cars.c lanes.c sprite.c rng.c arena.c cfg.c profile.c pacer.c -o "$OUTPUT_FILE" -pthread
+    [ $? -eq 0 ] && echo "Output file: $OUTPUT_FILE" >&2
+    exit
+fi
+
+if [ "$1" == "--test" ]; then
+    mkdir -p ./builds
+    for TEST in tests/*.c; do
+        OUTPUT_FILE="./builds/$(basename "$TEST" .c)_$(date +%s%N)"
+        gcc "$TEST" $(ls *.c | grep -v "^main.c$\|^bench.c$") -o "$OUTPUT_FILE" -lncurses -pthread -lm && ./"$OUTPUT_FILE" || exit 1
+    done
+    exit
+fi
 
 OUTPUT_FILE="./builds/main_$(date +%s%N)"
-gcc *.c -o "$OUTPUT_FILE" -lncurses
+gcc *.c -o "$OUTPUT_FILE" -lncurses -pthread
 
 if [ $? -eq 0 ]; then
-    echo "Output file: $OUTPUT_FILE"
-    ./"$OUTPUT_FILE"
-fi
\ No newline at end of file
+    echo "Output file: $OUTPUT_FILE" >&2
+    ./"$OUTPUT_FILE" "$@"   # e.g. ./build.sh --bench > bench.json
+fi
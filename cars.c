@@ -0,0 +1,762 @@
+// cars.c
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "sim.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CARS_X86 1
+#endif
+
+
+// --- CAR POOL FUNCTIONS ---
+// Aligned array of count ints
+int* AllocCarArray(ARENA* arena, int count)
+{
+    return (int*)ArenaCalloc(arena, count > 0 ? count : 1, sizeof(int));
+}
+
+// Put a new car into the slot - direction and disappearing from two random bits, starting at the wall it drives away from
+void PlaceCar(CAR_POOL* pool, CAR_STATE* car, uint64_t bits)
+{
+    car->direction = (int)(bits & 1);
+    car->disappearing = (int)((bits >> 1) & 1);
+    car->x = car->direction == 0 ? pool->xmax - pool->width : pool->xmin; // depends on initial direction
+}
+
+// Replace a disappearing car - the randomness depends only on the slot and its number of cars, not on the order of evaluation
+void RespawnCar(CAR_POOL* pool, int i, CAR_STATE* car)
+{
+    PlaceCar(pool, car, DeriveSeed(pool->seed, ((uint64_t)(uint32_t)(i - pool->base) << 32) | (uint32_t)car->spawns));
+    car->spawns++;
+}
+
+void LoadCar(CAR_POOL* pool, int i, CAR_STATE* car)
+{
+    car->x = pool->x[i];
+    car->direction = pool->direction[i];
+    car->phase = pool->phase[i];
+    car->disappearing = pool->disappearing[i];
+    car->spawns = pool->spawns[i];
+}
+
+void StoreCar(CAR_POOL* pool, int i, CAR_STATE* car)
+{
+    pool->x[i] = car->x;
+    pool->direction[i] = car->direction;
+    pool->phase[i] = car->phase;
+    pool->disappearing[i] = car->disappearing;
+    pool->spawns[i] = car->spawns;
+}
+
+// Car pool initializer - one car per lane, lanes separated by the frog's height
+CAR_POOL* InitCarPool(CARS_CFG* cfg, int cols, int frogHeight, int frame, int sprite, RNG* rng, ARENA* arena)
+{
+    CAR_POOL* pool = (CAR_POOL*)ArenaAlloc(arena, sizeof(CAR_POOL));
+    pool->count = cfg->nCars;
+    pool->width = cfg->width;
+    pool->height = cfg->height;
+    pool->xmin = 1;
+    pool->xmax = cols - 1;
+    pool->x = AllocCarArray(arena, pool->count);
+    pool->y = AllocCarArray(arena, pool->count);
+    pool->direction = AllocCarArray(arena, pool->count);
+    pool->moveFactor = AllocCarArray(arena, pool->count);
+    pool->phase = AllocCarArray(arena, pool->count);
+    pool->dynamicSpeed = AllocCarArray(arena, pool->count);
+    pool->disappearing = AllocCarArray(arena, pool->count);
+    pool->spawns = AllocCarArray(arena, pool->count);
+    pool->synced = AllocCarArray(arena, pool->count);
+    pool->type = (CarType*)ArenaAlloc(arena, (pool->count > 0 ? pool->count : 1) * sizeof(CarType));
+    pool->sprite = AllocCarArray(arena, pool->count);
+    pool->respawn = AllocCarArray(arena, pool->count);
+    pool->nRespawn = 0;
+    pool->sweep = cfg->moveFactor < WHEEL_MIN_FACTOR;
+    pool->due = AllocCarArray(arena, pool->count);
+    pool->next = AllocCarArray(arena, pool->count);
+    pool->prev = AllocCarArray(arena, pool->count);
+    pool->frame = 0;
+    pool->eagerFrom = 0;
+    pool->eagerTo = 0;
+    pool->base = 0;
+
+    for (int i = 0; i < pool->count; i++)
+    {
+        CAR_STATE car;
+        uint64_t direction = RandInt(rng, 0, 1);    // initial direction is random
+        uint64_t disappearing = RandInt(rng, 0, 1); // may disappear
+        PlaceCar(pool, &car, direction | disappearing << 1);
+        car.phase = frame % cfg->moveFactor;
+        car.spawns = 1;
+        StoreCar(pool, i, &car);
+        pool->dynamicSpeed[i] = 0;
+        pool->type[i] = Enemy;
+        pool->sprite[i] = sprite;
+        pool->moveFactor[i] = cfg->moveFactor;
+        pool->y[i] = i * (cfg->height + frogHeight) + frogHeight;
+    }
+    pool->seed = (uint64_t)NextRng(rng) << 32 | NextRng(rng);
+    pool->eagerTo = pool->count;    // until the game narrows it down
+    ResyncCars(pool);
+    return pool;
+}
+
+size_t CarPoolSize(int count)
+{
+    size_t array = ((count > 0 ? count : 1) * sizeof(int) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    return sizeof(CAR_POOL) + ARENA_ALIGN + 15 * (array + ARENA_ALIGN);
+}
+// Replace the disappearing cars that have hit a wall with new cars in the same slots
+void RespawnCars(CAR_POOL* pool)
+{
+    for (int i = 0; i < pool->nRespawn; i++)
+    {
+        CAR_STATE car;
+        LoadCar(pool, pool->respawn[i], &car);
+        RespawnCar(pool, pool->respawn[i], &car);
+        StoreCar(pool, pool->respawn[i], &car);
+    }
+    pool->nRespawn = 0;
+}
+
+// Queue the cars set in the mask (starting at car i) for respawning - hitting a wall is rare, so this is cheap
+void QueueRespawns(CAR_POOL* pool, int i, int mask)
+{
+    while (mask)
+    {
+        pool->respawn[pool->nRespawn++] = i + __builtin_ctz(mask);
+        mask &= mask - 1;
+    }
+}
+
+
+// --- ENDLESS ROAD ---
+uint64_t LaneBits(CAR_POOL* pool, int lane)
+{
+    return DeriveSeed(DeriveSeed(pool->seed, UINT64_MAX), (uint64_t)(uint32_t)lane);  // a stream of its own, apart from the new cars
+}
+
+int LaneMoveFactor(CAR_POOL* pool, int lane, int moveFactor)
+{
+    return moveFactor + (int)((LaneBits(pool, lane) >> 32) % (uint64_t)(moveFactor + 1));
+}
+
+void GenerateLane(CAR_POOL* pool, int lane, int moveFactor)
+{
+    int i = pool->base + pool->count - 1 - lane;
+    uint64_t bits = LaneBits(pool, lane);
+    CAR_STATE car;
+    PlaceCar(pool, &car, bits);
+    int right = pool->xmax - pool->width;
+    if (right > pool->xmin)
+    {
+        car.x = pool->xmin + (int)((bits >> 8) % (uint64_t)(right - pool->xmin + 1));
+    }
+    car.phase = 0;
+    car.spawns = 1;
+    StoreCar(pool, i, &car);
+    pool->moveFactor[i] = LaneMoveFactor(pool, lane, moveFactor);
+    pool->dynamicSpeed[i] = 0;
+    pool->type[i] = Enemy;
+    pool->synced[i] = pool->frame;
+}
+
+void ScrollCars(CAR_POOL* pool, int moveFactor)
+{
+    if (pool->count == 0)
+    {
+        return;
+    }
+    SetEagerCars(pool, 0, 0);   // nothing is scheduled, every car keeps the state of its own synced frame
+    size_t moved = (pool->count - 1) * sizeof(int);
+    memmove(pool->x + 1, pool->x, moved);
+    memmove(pool->direction + 1, pool->direction, moved);
+    memmove(pool->moveFactor + 1, pool->moveFactor, moved);
+    memmove(pool->phase + 1, pool->phase, moved);
+    memmove(pool->dynamicSpeed + 1, pool->dynamicSpeed, moved);
+    memmove(pool->disappearing + 1, pool->disappearing, moved);
+    memmove(pool->spawns + 1, pool->spawns, moved);
+    memmove(pool->synced + 1, pool->synced, moved);
+    memmove(pool->sprite + 1, pool->sprite, moved);
+    memmove(pool->type + 1, pool->type, (pool->count - 1) * sizeof(CarType));
+    pool->base++;   // i - base of every car is unchanged, so are its new cars
+    GenerateLane(pool, pool->base + pool->count - 1, moveFactor);
+}
+
+
+// --- CLOSED FORM ---
+// A car bounces between xmin and right = xmax - width. Unfolded, it runs around a circle of 2L positions
+// (L = right - xmin): u = x - xmin while it drives right and 2L - (x - xmin) while it drives left.
+// It moves one position in every frame that starts with phase 0 and turns around at the start of the frame
+// after the one it has reached a wall in - which is also when a disappearing car is replaced.
+
+// Advance a car that is not replaced within the given frames
+void JumpCar(CAR_POOL* pool, int i, CAR_STATE* car, int frames)
+{
+    int m = pool->moveFactor[i];
+    int right = pool->xmax - pool->width;
+    int length = right - pool->xmin;
+    int first = (m - car->phase) % m;   // frames until the first move
+    int moves = frames > first ? (frames - 1 - first) / m + 1 : 0;
+    int lastMoved = moves > 0 && (car->phase + frames - 1) % m == 0;
+    car->phase = (int)(((long)car->phase + frames) % m);
+    if (length < 0)
+    {
+        return; // wider than the road - stuck
+    }
+    if (length == 0)
+    {
+        car->direction ^= frames & 1;   // turns around every frame
+        return;
+    }
+
+    int circle = 2 * length;
+    int u = car->direction == 1 ? car->x - pool->xmin : circle - (car->x - pool->xmin);
+    u = (int)(((long)u + moves) % circle);
+    car->x = pool->xmin + (u <= length ? u : circle - u);
+    if (u == length)
+    {
+        car->direction = lastMoved ? 1 : 0;  // not turned around yet if it has just arrived
+    }
+    else if (u == 0)
+    {
+        car->direction = lastMoved ? 0 : 1;
+    }
+    else
+    {
+        car->direction = u < length ? 1 : 0;
+    }
+}
+
+// Frames until the car turns around (it is replaced then, if it is disappearing) - the frame it happens in
+int FramesToTurn(CAR_POOL* pool, int i, CAR_STATE* car)
+{
+    int right = pool->xmax - pool->width;
+    if ((car->direction == 1 && car->x == right) || (car->direction == 0 && car->x == pool->xmin))
+    {
+        return 0;
+    }
+    if (right < pool->xmin)
+    {
+        return -1;  // never
+    }
+    int m = pool->moveFactor[i];
+    int distance = car->direction == 1 ? right - car->x : car->x - pool->xmin;
+    return (m - car->phase) % m + (distance - 1) * m + 1;
+}
+
+// Advance a car by any number of frames - closed form between the new cars in the slot
+void AdvanceCar(CAR_POOL* pool, int i, CAR_STATE* car, int frames)
+{
+    while (frames > 0)
+    {
+        int turn = car->disappearing ? FramesToTurn(pool, i, car) : -1;
+        if (turn < 0 || turn >= frames)
+        {
+            JumpCar(pool, i, car, frames);
+            return;
+        }
+        JumpCar(pool, i, car, turn);
+        car->phase = car->phase + 1 == pool->moveFactor[i] ? 0 : car->phase + 1;  // the frame it turns in - position is replaced
+        RespawnCar(pool, i, car);
+        frames -= turn + 1;
+    }
+}
+
+// Frame the stored state of a car belongs to - swept eager cars are stepped every frame
+int SyncedFrame(CAR_POOL* pool, int i)
+{
+    return pool->sweep && i >= pool->eagerFrom && i < pool->eagerTo ? pool->frame : pool->synced[i];
+}
+
+void PredictCar(CAR_POOL* pool, int i, int frames, CAR_STATE* car)
+{
+    LoadCar(pool, i, car);
+    AdvanceCar(pool, i, car, frames + pool->frame - SyncedFrame(pool, i));
+}
+
+void SyncCars(CAR_POOL* pool, int from, int to)
+{
+    for (int i = from; i < to; i++)
+    {
+        if (SyncedFrame(pool, i) != pool->frame)
+        {
+            CAR_STATE car;
+            PredictCar(pool, i, 0, &car);   // a woken eager car has not changed since, its schedule stays valid
+            StoreCar(pool, i, &car);
+            pool->synced[i] = pool->frame;
+        }
+    }
+}
+
+
+// --- SCHEDULER ---
+// Link a car into the slot of its due frame
+void InsertCar(CAR_POOL* pool, int i)
+{
+    int slot = pool->due[i] & (WHEEL_SLOTS - 1);
+    pool->prev[i] = -1;
+    pool->next[i] = pool->wheel[slot];
+    if (pool->wheel[slot] >= 0)
+    {
+        pool->prev[pool->wheel[slot]] = i;
+    }
+    pool->wheel[slot] = i;
+}
+
+// Put an up to date eager car into the slot of its next move or turn (nowhere if it never changes)
+void ScheduleCar(CAR_POOL* pool, int i)
+{
+    int right = pool->xmax - pool->width;
+    if ((pool->direction[i] == 1 && pool->x[i] == right) || (pool->direction[i] == 0 && pool->x[i] == pool->xmin))
+    {
+        pool->due[i] = pool->frame;     // turns around now
+    }
+    else if (right < pool->xmin)
+    {
+        pool->due[i] = -1;              // wider than the road - stuck
+        return;
+    }
+    else
+    {
+        pool->due[i] = pool->frame + (pool->phase[i] == 0 ? 0 : pool->moveFactor[i] - pool->phase[i]);
+    }
+    InsertCar(pool, i);
+}
+
+void UnscheduleCar(CAR_POOL* pool, int i)
+{
+    if (pool->due[i] < 0)
+    {
+        return;
+    }
+    if (pool->prev[i] >= 0)
+    {
+        pool->next[pool->prev[i]] = pool->next[i];
+    }
+    else
+    {
+        pool->wheel[pool->due[i] & (WHEEL_SLOTS - 1)] = pool->next[i];
+    }
+    if (pool->next[i] >= 0)
+    {
+        pool->prev[pool->next[i]] = pool->prev[i];
+    }
+    pool->due[i] = -1;
+}
+
+// Play the frame a car is due in - it turns around (or is replaced) and/or moves, then it is up to date for the next frame
+// Cheaper than SyncCars: a due car is either at a wall or at phase 0, no division is needed
+void StepDueCar(CAR_POOL* pool, int i, int frame)
+{
+    int right = pool->xmax - pool->width;
+    int m = pool->moveFactor[i];
+    int phase = frame == pool->synced[i] ? pool->phase[i] : 0;
+    if ((pool->direction[i] == 1 && pool->x[i] == right) || (pool->direction[i] == 0 && pool->x[i] == pool->xmin))
+    {
+        pool->direction[i] = 1 - pool->direction[i];
+        if (pool->disappearing[i])
+        {
+            CAR_STATE car;
+            LoadCar(pool, i, &car);
+            RespawnCar(pool, i, &car);
+            StoreCar(pool, i, &car);
+            phase = -1;     // replaced - the old car's move does not matter
+        }
+    }
+    if (phase == 0)
+    {
+        if (pool->direction[i] == 1 && pool->x[i] < right)
+        {
+            pool->x[i]++;
+        }
+        else if (pool->direction[i] == 0 && pool->x[i] > pool->xmin)
+        {
+            pool->x[i]--;
+        }
+    }
+    phase = phase < 0 ? (frame - pool->synced[i] + pool->phase[i]) % m : phase;
+    pool->phase[i] = phase + 1 == m ? 0 : phase + 1;
+    pool->synced[i] = frame + 1;
+}
+
+// Wake the eager cars due in this frame
+void WakeCars(CAR_POOL* pool)
+{
+    int frame = pool->frame;
+    int slot = frame & (WHEEL_SLOTS - 1);
+    int i = pool->wheel[slot];
+    pool->wheel[slot] = -1;     // the whole slot is taken out, cars due in later turns of the wheel are put back
+    pool->frame++;              // due cars are scheduled from the next frame on
+    while (i >= 0)
+    {
+        int next = pool->next[i];
+        if (pool->due[i] == frame)
+        {
+            StepDueCar(pool, i, frame);
+            ScheduleCar(pool, i);
+        }
+        else
+        {
+            InsertCar(pool, i);
+        }
+        i = next;
+    }
+}
+
+// First car whose lane reaches down to row y or further (cars are ordered by lane)
+int FirstCarBelow(CAR_POOL* pool, int y)
+{
+    int low = 0;
+    int high = pool->count;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (pool->y[middle] + pool->height > y)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+void CarsInRows(CAR_POOL* pool, int ymin, int ymax, int* from, int* to)
+{
+    *from = FirstCarBelow(pool, ymin);
+    *to = FirstCarBelow(pool, ymax + pool->height - 1);    // first car starting at ymax or below
+    *to = *to > *from ? *to : *from;
+}
+
+void SetEagerCars(CAR_POOL* pool, int ymin, int ymax)
+{
+    int from, to;
+    CarsInRows(pool, ymin, ymax, &from, &to);
+    for (int i = pool->eagerFrom; i < pool->eagerTo; i++)
+    {
+        if (i < from || i >= to)
+        {
+            if (pool->sweep)
+            {
+                pool->synced[i] = pool->frame;  // leaving cars are up to date
+            }
+            else
+            {
+                UnscheduleCar(pool, i);         // leaving cars keep the state of their last change
+            }
+        }
+    }
+    for (int i = from; i < to; i++)
+    {
+        if (i < pool->eagerFrom || i >= pool->eagerTo)
+        {
+            SyncCars(pool, i, i + 1);   // joining cars are brought up to date
+            if (!pool->sweep)
+            {
+                ScheduleCar(pool, i);
+            }
+        }
+    }
+    pool->eagerFrom = from;
+    pool->eagerTo = to;
+}
+
+void ResyncCars(CAR_POOL* pool)
+{
+    for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+    {
+        pool->wheel[slot] = -1;
+    }
+    for (int i = 0; i < pool->count; i++)
+    {
+        pool->synced[i] = pool->frame;
+        pool->due[i] = -1;
+    }
+    for (int i = pool->eagerFrom; i < pool->eagerTo && !pool->sweep; i++)
+    {
+        ScheduleCar(pool, i);
+    }
+}
+
+void RetimeCars(CAR_POOL* pool, int moveFactor, int endless)
+{
+    SyncCars(pool, 0, pool->count);
+    for (int i = 0; i < pool->count; i++)
+    {
+        pool->moveFactor[i] = endless ? LaneMoveFactor(pool, pool->base + pool->count - 1 - i, moveFactor) : moveFactor;
+        pool->phase[i] %= pool->moveFactor[i];
+    }
+    pool->sweep = moveFactor < WHEEL_MIN_FACTOR;
+    ResyncCars(pool);
+}
+
+
+// --- SCALAR KERNELS ---
+// Reverse direction when the car hits the wall (bouncing), then step if the car is due
+void UpdateCarsScalar(CAR_POOL* pool, int from, int to)
+{
+    int right = pool->xmax - pool->width;
+    for (int i = from; i < to; i++)
+    {
+        if ((pool->direction[i] == 1 && pool->x[i] == right) || (pool->direction[i] == 0 && pool->x[i] == pool->xmin))
+        {
+            pool->direction[i] = 1 - pool->direction[i];
+            if (pool->disappearing[i])
+            {
+                QueueRespawns(pool, i, 1);
+            }
+        }
+
+        if (pool->phase[i] == 0)
+        {
+            if (pool->direction[i] == 1 && pool->x[i] < right)
+            {
+                pool->x[i]++;
+            }
+            else if (pool->direction[i] == 0 && pool->x[i] > pool->xmin)
+            {
+                pool->x[i]--;
+            }
+        }
+        pool->phase[i] = pool->phase[i] + 1 == pool->moveFactor[i] ? 0 : pool->phase[i] + 1;
+    }
+}
+
+int CollideCarsScalar(CAR_POOL* pool, int from, int x, int y, int width, int height)
+{
+    for (int i = from; i < pool->count; i++)
+    {
+        if (pool->y[i] < y + height && y < pool->y[i] + pool->height &&
+            pool->x[i] < x + width && x < pool->x[i] + pool->width)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// --- SIMD KERNELS ---
+// Each kernel handles whole vectors and returns where it has stopped, the scalar kernel does the rest
+// The update kernels start at an index aligned to the vector size
+#ifdef CARS_X86
+__attribute__((target("avx2")))
+int UpdateCarsAvx2(CAR_POOL* pool, int from, int to)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i left = _mm256_set1_epi32(pool->xmin);
+    const __m256i right = _mm256_set1_epi32(pool->xmax - pool->width);
+    int n = from + ((to - from) & ~7);
+    for (int i = from; i < n; i += 8)
+    {
+        __m256i x = _mm256_load_si256((__m256i*)(pool->x + i));
+        __m256i dir = _mm256_load_si256((__m256i*)(pool->direction + i));
+        __m256i phase = _mm256_load_si256((__m256i*)(pool->phase + i));
+        __m256i factor = _mm256_load_si256((__m256i*)(pool->moveFactor + i));
+
+        __m256i goingRight = _mm256_cmpeq_epi32(dir, one);
+        __m256i bounce = _mm256_or_si256(
+            _mm256_and_si256(goingRight, _mm256_cmpeq_epi32(x, right)),
+            _mm256_andnot_si256(goingRight, _mm256_cmpeq_epi32(x, left)));
+        dir = _mm256_xor_si256(dir, _mm256_and_si256(bounce, one));
+        __m256i gone = _mm256_and_si256(bounce, _mm256_cmpeq_epi32(_mm256_load_si256((__m256i*)(pool->disappearing + i)), one));
+        QueueRespawns(pool, i, _mm256_movemask_ps(_mm256_castsi256_ps(gone)));
+        goingRight = _mm256_cmpeq_epi32(dir, one);
+
+        __m256i canMove = _mm256_or_si256(
+            _mm256_and_si256(goingRight, _mm256_cmpgt_epi32(right, x)),
+            _mm256_andnot_si256(goingRight, _mm256_cmpgt_epi32(x, left)));
+        __m256i step = _mm256_sub_epi32(_mm256_slli_epi32(dir, 1), one);   // -1 or 1
+        __m256i due = _mm256_and_si256(_mm256_cmpeq_epi32(phase, zero), canMove);
+        x = _mm256_add_epi32(x, _mm256_and_si256(step, due));
+
+        phase = _mm256_add_epi32(phase, one);
+        phase = _mm256_andnot_si256(_mm256_cmpeq_epi32(phase, factor), phase);
+
+        _mm256_store_si256((__m256i*)(pool->x + i), x);
+        _mm256_store_si256((__m256i*)(pool->direction + i), dir);
+        _mm256_store_si256((__m256i*)(pool->phase + i), phase);
+    }
+    return n;
+}
+
+__attribute__((target("avx2")))
+int CollideCarsAvx2(CAR_POOL* pool, int x, int y, int width, int height, int* hit)
+{
+    // car.x in (x - car width, x + width) and car.y in (y - car height, y + height)
+    const __m256i xlo = _mm256_set1_epi32(x - pool->width);
+    const __m256i xhi = _mm256_set1_epi32(x + width);
+    const __m256i ylo = _mm256_set1_epi32(y - pool->height);
+    const __m256i yhi = _mm256_set1_epi32(y + height);
+    int n = pool->count & ~7;
+    for (int i = 0; i < n; i += 8)
+    {
+        __m256i cx = _mm256_load_si256((__m256i*)(pool->x + i));
+        __m256i cy = _mm256_load_si256((__m256i*)(pool->y + i));
+        __m256i overlap = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(cx, xlo), _mm256_cmpgt_epi32(xhi, cx)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(cy, ylo), _mm256_cmpgt_epi32(yhi, cy)));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(overlap));
+        if (mask)
+        {
+            *hit = i + __builtin_ctz(mask);
+            return n;
+        }
+    }
+    *hit = -1;
+    return n;
+}
+
+__attribute__((target("sse2")))
+int UpdateCarsSse2(CAR_POOL* pool, int from, int to)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i left = _mm_set1_epi32(pool->xmin);
+    const __m128i right = _mm_set1_epi32(pool->xmax - pool->width);
+    int n = from + ((to - from) & ~3);
+    for (int i = from; i < n; i += 4)
+    {
+        __m128i x = _mm_load_si128((__m128i*)(pool->x + i));
+        __m128i dir = _mm_load_si128((__m128i*)(pool->direction + i));
+        __m128i phase = _mm_load_si128((__m128i*)(pool->phase + i));
+        __m128i factor = _mm_load_si128((__m128i*)(pool->moveFactor + i));
+
+        __m128i goingRight = _mm_cmpeq_epi32(dir, one);
+        __m128i bounce = _mm_or_si128(
+            _mm_and_si128(goingRight, _mm_cmpeq_epi32(x, right)),
+            _mm_andnot_si128(goingRight, _mm_cmpeq_epi32(x, left)));
+        dir = _mm_xor_si128(dir, _mm_and_si128(bounce, one));
+        __m128i gone = _mm_and_si128(bounce, _mm_cmpeq_epi32(_mm_load_si128((__m128i*)(pool->disappearing + i)), one));
+        QueueRespawns(pool, i, _mm_movemask_ps(_mm_castsi128_ps(gone)));
+        goingRight = _mm_cmpeq_epi32(dir, one);
+
+        __m128i canMove = _mm_or_si128(
+            _mm_and_si128(goingRight, _mm_cmpgt_epi32(right, x)),
+            _mm_andnot_si128(goingRight, _mm_cmpgt_epi32(x, left)));
+        __m128i step = _mm_sub_epi32(_mm_slli_epi32(dir, 1), one);
+        __m128i due = _mm_and_si128(_mm_cmpeq_epi32(phase, zero), canMove);
+        x = _mm_add_epi32(x, _mm_and_si128(step, due));
+
+        phase = _mm_add_epi32(phase, one);
+        phase = _mm_andnot_si128(_mm_cmpeq_epi32(phase, factor), phase);
+
+        _mm_store_si128((__m128i*)(pool->x + i), x);
+        _mm_store_si128((__m128i*)(pool->direction + i), dir);
+        _mm_store_si128((__m128i*)(pool->phase + i), phase);
+    }
+    return n;
+}
+
+__attribute__((target("sse2")))
+int CollideCarsSse2(CAR_POOL* pool, int x, int y, int width, int height, int* hit)
+{
+    const __m128i xlo = _mm_set1_epi32(x - pool->width);
+    const __m128i xhi = _mm_set1_epi32(x + width);
+    const __m128i ylo = _mm_set1_epi32(y - pool->height);
+    const __m128i yhi = _mm_set1_epi32(y + height);
+    int n = pool->count & ~3;
+    for (int i = 0; i < n; i += 4)
+    {
+        __m128i cx = _mm_load_si128((__m128i*)(pool->x + i));
+        __m128i cy = _mm_load_si128((__m128i*)(pool->y + i));
+        __m128i overlap = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(cx, xlo), _mm_cmpgt_epi32(xhi, cx)),
+            _mm_and_si128(_mm_cmpgt_epi32(cy, ylo), _mm_cmpgt_epi32(yhi, cy)));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(overlap));
+        if (mask)
+        {
+            *hit = i + __builtin_ctz(mask);
+            return n;
+        }
+    }
+    *hit = -1;
+    return n;
+}
+
+// 2 for AVX2, 1 for SSE2 - checked once (atomic, games may run on several threads)
+int SimdLevel()
+{
+    static _Atomic int level = -1;
+    int cached = atomic_load_explicit(&level, memory_order_relaxed);
+    if (cached < 0)
+    {
+        __builtin_cpu_init();
+        cached = __builtin_cpu_supports("avx2") ? 2 : (__builtin_cpu_supports("sse2") ? 1 : 0);
+        atomic_store_explicit(&level, cached, memory_order_relaxed);
+    }
+    return cached;
+}
+#endif // CARS_X86
+
+
+// --- KERNELS ---
+// Step every eager car one frame
+void SweepCars(CAR_POOL* pool)
+{
+    pool->nRespawn = 0;
+    int from = pool->eagerFrom;
+    int to = pool->eagerTo;
+    int done = from;
+#ifdef CARS_X86
+    int aligned = (from + 7) & ~7;  // the vector kernels use aligned loads
+    if (SimdLevel() > 0 && aligned < to)
+    {
+        UpdateCarsScalar(pool, from, aligned);
+        done = SimdLevel() == 2 ? UpdateCarsAvx2(pool, aligned, to) : UpdateCarsSse2(pool, aligned, to);
+    }
+#endif
+    UpdateCarsScalar(pool, done, to);
+    RespawnCars(pool);
+}
+
+int CollideCars(CAR_POOL* pool, int x, int y, int width, int height)
+{
+    SyncCars(pool, 0, pool->count);
+    int done = 0;
+#ifdef CARS_X86
+    int hit = -1;
+    switch (SimdLevel())
+    {
+        case 2:
+            done = CollideCarsAvx2(pool, x, y, width, height, &hit);
+            break;
+        case 1:
+            done = CollideCarsSse2(pool, x, y, width, height, &hit);
+            break;
+    }
+    if (hit >= 0)
+    {
+        return hit;
+    }
+#endif
+    return CollideCarsScalar(pool, done, x, y, width, height);
+}
+
+void UpdateCars(CAR_POOL* pool)
+{
+    if (pool->sweep)
+    {
+        SweepCars(pool);
+        pool->frame++;
+    }
+    else
+    {
+        WakeCars(pool);
+    }
+}
+
+const char* CarKernelName()
+{
+#ifdef CARS_X86
+    static const char* names[] = { "scalar", "sse2", "avx2" };
+    return names[SimdLevel()];
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,101 @@
+// cars.h
+#ifndef CARS_H
+#define CARS_H
+
+#include "cfg.h"
+#include "arena.h"
+#include "rng.h"
+
+typedef enum {
+    Enemy,      // normal car
+    Neutral,    // stops when the frog is close
+    Friendly    // helps the frog on demand
+} CarType;
+
+// State of a single car - what changes while it drives
+typedef struct {
+    int x;
+    int direction;
+    int phase;
+    int disappearing;
+    int spawns;
+} CAR_STATE;
+
+#define WHEEL_SLOTS 64  // slots of the timing wheel, power of 2
+#define WHEEL_MIN_FACTOR 32     // slower cars are woken by the wheel, faster ones are cheaper to sweep with the vector kernels
+
+// Car pool - struct of arrays, one entry per car, so that the kernels run over contiguous memory
+// Cars are ordered by lane (y ascending). Every car keeps the state of frame synced[i] and is brought up to date
+// in closed form when queried. The x and direction of the eager cars [eagerFrom, eagerTo) are always current:
+// fast cars are stepped every frame by the vector kernels (sweep), slow cars are woken by a hashed timing wheel
+// only in the frames in which they move or turn around
+typedef struct {
+    int count;
+    int width, height;  // shared by all cars
+    int xmin, xmax;     // movement boundaries
+    int* x;             // top-left corner coordinates
+    int* y;             // cars don't move vertically
+    int* direction;     // 0 for left, 1 for right
+    int* moveFactor;    // frames per step
+    int* phase;         // frame % moveFactor, the car steps when it is 0
+    int* dynamicSpeed;  // 0 for constant speed, 1 for dynamic
+    int* disappearing;  // 0 for perpetually bouncing car, 1 for disappearing (replaced with a new car)
+    int* spawns;        // cars that have been put into the slot so far - picks the randomness of the next one
+    int* synced;        // frame the state belongs to (swept eager cars: the current frame)
+    CarType* type;
+    int* sprite;        // id in the sprite atlas - variants must share the pool's width and height
+    int* respawn;       // swept disappearing cars that have hit a wall in this frame
+    int nRespawn;
+    int sweep;          // 1 if the eager cars are swept every frame, 0 if they are woken by the wheel
+    int* due;           // frame of the next move or turn of a woken eager car
+    int* next;          // doubly linked lists of the wheel slots, -1 terminated
+    int* prev;
+    int wheel[WHEEL_SLOTS];     // first car of every slot - cars due at frame f are in slot f % WHEEL_SLOTS
+    int frame;          // frames the pool has been updated
+    int eagerFrom, eagerTo;
+    int base;           // lanes scrolled out of the endless road - slot i holds lane base + count - 1 - i
+    uint64_t seed;      // of the new cars - car i gets DeriveSeed(seed, (i - base) << 32 | spawns), in any evaluation order
+} CAR_POOL;
+
+// --- CAR POOL FUNCTIONS ---
+// Car pool initializer - fixed capacity, slots of disappearing cars are reused for the new cars
+CAR_POOL* InitCarPool(CARS_CFG* cfg, int cols, int frogHeight, int frame, int sprite, RNG* rng, ARENA* arena);
+// Arena memory needed by a pool of count cars
+size_t CarPoolSize(int count);
+// Cars [from, to) are the ones in lanes overlapping rows [ymin, ymax) - binary search, cars are ordered by lane
+void CarsInRows(CAR_POOL* pool, int ymin, int ymax, int* from, int* to);
+
+// --- ENDLESS ROAD ---
+// The pool is a fixed ring of lane slots over an endless road - lane 0 is the bottom one, new lanes come in at the top
+// Random bits of a lane - the same whenever the lane is generated, so the road only depends on the seed
+uint64_t LaneBits(CAR_POOL* pool, int lane);
+// Frames per step of the cars of a lane - moveFactor to 2 * moveFactor
+int LaneMoveFactor(CAR_POOL* pool, int lane, int moveFactor);
+// Put the car of the given lane into its slot - random direction, position and speed (moveFactor to 2 * moveFactor)
+void GenerateLane(CAR_POOL* pool, int lane, int moveFactor);
+// Recycle the bottom slot - every car moves one slot (one lane pitch) down and the next lane comes in at the top
+// No allocation and O(count) copying, the eager cars are picked again by the next SetEagerCars
+void ScrollCars(CAR_POOL* pool, int moveFactor);
+
+// --- CLOSED FORM ---
+// State of car i the given number of frames from now, new cars in the slot included - O(1) per car that passes by
+void PredictCar(CAR_POOL* pool, int i, int frames, CAR_STATE* car);
+// Step only the cars in lanes overlapping rows [ymin, ymax) every frame, the others lazily
+void SetEagerCars(CAR_POOL* pool, int ymin, int ymax);
+// Bring the cars among [from, to) up to date
+void SyncCars(CAR_POOL* pool, int from, int to);
+// Rebuild the schedule after the state arrays have been overwritten with the state of the current frame
+void ResyncCars(CAR_POOL* pool);
+// Change the speed of every car from the current frame on (a reloaded config) - the endless road keeps the spread
+// of its lanes, moveFactor to 2 * moveFactor
+void RetimeCars(CAR_POOL* pool, int moveFactor, int endless);
+
+// --- KERNELS (SSE2/AVX2 when available, scalar otherwise) ---
+// Move, turn around or replace the eager cars - all of them (sweep) or only the ones due in this frame (wheel)
+void UpdateCars(CAR_POOL* pool);
+// Index of the first car overlapping the given box, -1 if none - checks every car
+int CollideCars(CAR_POOL* pool, int x, int y, int width, int height);
+// "avx2", "sse2" or "scalar" - the kernels picked for this CPU
+const char* CarKernelName();
+
+#endif // CARS_H
@@ -1,7 +1,14 @@
 // cfg.c
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <stddef.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cfg.h"
 
 // --- DEFAULT SETTINGS ---
@@ -16,6 +23,7 @@ const int STATUS_ROWS = 3;
 const int PLAYABLE_COLS = 100;  // the same for both windows
 const int OFFY = 0;             // optional: window offset within the main window
 const int OFFX = 0;
+const int ENDLESS = 0;          // 1 for the endless road (also --endless)
 
 // Frog
 const int FROG_MOVE_FACTOR = 5;
@@ -51,6 +59,7 @@ void LoadAreaDefaults(AREA_CFG* area)
     area->cols = PLAYABLE_COLS;
     area->offy = OFFY;
     area->offx = OFFX;
+    area->endless = ENDLESS;
 }
 
 void LoadFrogDefaults(FROG_CFG* frog)
@@ -111,85 +120,469 @@ void LoadCfgDefaults(CFG* cfg)
 }
 
 
-// --- LOADING CONFIGURATION FROM FILE ---
-void LoadTimingFromFile(TIMING_CFG* timing, FILE* file)
+// --- SETTINGS FILE ---
+const char* CFG_SECTION_NAMES[CFG_SECTIONS] = { "TIMING", "AREA", "FROG", "CARS", "CONTROLS" };
+
+const CFG_SETTING CFG_SETTINGS[] = {
+    { "FRAME_TIME", SECTION_TIMING, offsetof(TIMING_CFG, frameTime), 1, 60000, 0 },
+    { "INITIAL_TIME", SECTION_TIMING, offsetof(TIMING_CFG, initialTime), 1, 1000000, 0 },
+    { "QUIT_TIME", SECTION_TIMING, offsetof(TIMING_CFG, quitTime), 0, 3600, 0 },
+    { "PLAYABLE_ROWS", SECTION_AREA, offsetof(AREA_CFG, playableRows), 3, 1 << 24, 0 },
+    { "STATUS_ROWS", SECTION_AREA, offsetof(AREA_CFG, statusRows), 3, 1000, 0 },
+    { "COLS", SECTION_AREA, offsetof(AREA_CFG, cols), 3, 1 << 24, 0 },
+    { "OFFY", SECTION_AREA, offsetof(AREA_CFG, offy), 0, 10000, 0 },
+    { "OFFX", SECTION_AREA, offsetof(AREA_CFG, offx), 0, 10000, 0 },
+    { "ENDLESS", SECTION_AREA, offsetof(AREA_CFG, endless), 0, 1, 0 },
+    { "FROG_MOVE_FACTOR", SECTION_FROG, offsetof(FROG_CFG, moveFactor), 0, 100000, 0 },
+    { "FROG_WIDTH", SECTION_FROG, offsetof(FROG_CFG, width), 1, CFG_MAX_SHAPE, 0 },
+    { "FROG_HEIGHT", SECTION_FROG, offsetof(FROG_CFG, height), 1, CFG_MAX_SHAPE, 0 },
+    { "N_CARS", SECTION_CARS, offsetof(CARS_CFG, nCars), 0, 1 << 24, 0 },
+    { "CAR_MOVE_FACTOR", SECTION_CARS, offsetof(CARS_CFG, moveFactor), 1, 100000, 0 },
+    { "CAR_WIDTH", SECTION_CARS, offsetof(CARS_CFG, width), 1, CFG_MAX_SHAPE, 0 },
+    { "CAR_HEIGHT", SECTION_CARS, offsetof(CARS_CFG, height), 1, CFG_MAX_SHAPE, 0 },
+    { "UP", SECTION_CONTROLS, offsetof(CONTROLS_CFG, up), 1, 511, 1 },    // up to the ncurses key codes
+    { "DOWN", SECTION_CONTROLS, offsetof(CONTROLS_CFG, down), 1, 511, 1 },
+    { "LEFT", SECTION_CONTROLS, offsetof(CONTROLS_CFG, left), 1, 511, 1 },
+    { "RIGHT", SECTION_CONTROLS, offsetof(CONTROLS_CFG, right), 1, 511, 1 },
+    { "QUIT", SECTION_CONTROLS, offsetof(CONTROLS_CFG, quit), 1, 511, 1 },
+};
+#define N_CFG_SETTINGS ((int)(sizeof(CFG_SETTINGS) / sizeof(CFG_SETTING)))
+
+// Shape blocks of the settings file
+const char* CFG_SHAPE_KEYS[2] = { "FROG_SHAPE:", "CAR_SHAPE:" };
+const CfgSection CFG_SHAPE_SECTIONS[2] = { SECTION_FROG, SECTION_CARS };
+
+// Settings file being parsed - errors are counted and reported as they are found
+typedef struct {
+    const char* filename;
+    FILE* err;
+    int errors;
+} CFG_PARSER;
+
+void CfgError(CFG_PARSER* parser, int line, int column, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    if (line > 0)
+    {
+        fprintf(parser->err, "%s:%d:%d: ", parser->filename, line, column);
+    }
+    else
+    {
+        fprintf(parser->err, "%s: ", parser->filename);
+    }
+    vfprintf(parser->err, format, args);
+    fputc('\n', parser->err);
+    va_end(args);
+    parser->errors++;
+}
+
+// Structure of a section
+void* CfgSectionOf(CFG* cfg, CfgSection section)
 {
-    fscanf(file, "FRAME_TIME=%d\n", &timing->frameTime);
-    fscanf(file, "INITIAL_TIME=%d\n", &timing->initialTime);
-    fscanf(file, "QUIT_TIME=%d\n", &timing->quitTime);
+    void* sections[CFG_SECTIONS] = { cfg->timing, cfg->area, cfg->frog, cfg->cars, cfg->controls };
+    return sections[section];
 }
 
-void LoadAreaFromFile(AREA_CFG* area, FILE* file)
+const CFG_SETTING* FindCfgSetting(const char* name)
 {
-    fscanf(file, "PLAYABLE_ROWS=%d\n", &area->playableRows);
-    fscanf(file, "STATUS_ROWS=%d\n", &area->statusRows);
-    fscanf(file, "COLS=%d\n", &area->cols);
-    fscanf(file, "OFFY=%d\n", &area->offy);
-    fscanf(file, "OFFX=%d\n", &area->offx);
+    for (int i = 0; i < N_CFG_SETTINGS; i++)
+    {
+        if (strcmp(CFG_SETTINGS[i].name, name) == 0)
+        {
+            return &CFG_SETTINGS[i];
+        }
+    }
+    return NULL;
 }
 
-void LoadFrogFromFile(FROG_CFG* frog, FILE* file)
+int* CfgField(CFG* cfg, const CFG_SETTING* setting)
 {
-    fscanf(file, "FROG_MOVE_FACTOR=%d\n", &frog->moveFactor);
-    fscanf(file, "FROG_WIDTH=%d\n", &frog->width);
-    fscanf(file, "FROG_HEIGHT=%d\n", &frog->height);
-    // TODO: handle shape assignment
+    return (int*)((char*)CfgSectionOf(cfg, setting->section) + setting->offset);
 }
 
-void LoadCarsFromFile(CARS_CFG* cars, FILE* file)
+// Integer value of the whole text (optionally negative) - 0 if it is not one, -1 if it does not fit an int
+int ParseCfgInt(const char* text, int length, int* value)
 {
-    fscanf(file, "N_CARS=%d\n", &cars->nCars);
-    fscanf(file, "CAR_MOVE_FACTOR=%d\n", &cars->moveFactor);
-    fscanf(file, "CAR_WIDTH=%d\n", &cars->width);
-    fscanf(file, "CAR_HEIGHT=%d\n", &cars->height);
-    // TODO: handle shape assignment
+    int negative = text[0] == '-';
+    long limit = negative ? -(long)INT_MIN : INT_MAX;
+    long result = 0;
+    int overflow = 0;
+    if (negative == length)
+    {
+        return 0;
+    }
+    for (int i = negative; i < length; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return 0;
+        }
+        int digit = text[i] - '0';
+        overflow |= result > (limit - digit) / 10;  // checked before it is accumulated
+        result = overflow ? result : result * 10 + digit;
+    }
+    if (overflow)
+    {
+        return -1;
+    }
+    *value = (int)(negative ? -result : result);
+    return 1;
 }
 
-void LoadControlsFromFile(CONTROLS_CFG* controls, FILE* file)
+// Copy a shape row, "\\" stands for a backslash - its length, -1 if it is too long
+int UnescapeShapeRow(const char* text, int length, char* row)
 {
-    fscanf(file, "UP=%d\n", &controls->up);
-    fscanf(file, "DOWN=%d\n", &controls->down);
-    fscanf(file, "LEFT=%d\n", &controls->left);
-    fscanf(file, "RIGHT=%d\n", &controls->right);
-    fscanf(file, "QUIT=%d\n", &controls->quit);
+    int n = 0;
+    for (int i = 0; i < length; i++)
+    {
+        if (n == CFG_MAX_SHAPE)
+        {
+            return -1;
+        }
+        row[n++] = text[i];
+        i += text[i] == '\\' && i + 1 < length && text[i + 1] == '\\';
+    }
+    row[n] = '\0';
+    return n;
 }
 
-// Load config from file and override default values
-void LoadCfgFromFile(CFG* cfg, const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        return; // file not found
+// Does the shape fit its width and height - the location is that of its block, or of the setting that has changed it
+void CheckShape(CFG_PARSER* parser, char** shape, int rows, int line, const char* name, int width, int height)
+{
+    if (rows != height)
+    {
+        CfgError(parser, line, 1, "%s has %d rows, the height is %d", name, rows, height);
+    }
+    for (int i = 0; i < rows; i++)
+    {
+        if ((int)strlen(shape[i]) > width)
+        {
+            CfgError(parser, line ? line + 1 + i : 0, width + 1, "%s row %d is wider than %d", name, i + 1, width);
+        }
     }
+}
+
+// Shape of height rows of width characters, short rows padded with spaces
+char** CopyShape(char** rows, int width, int height)
+{
+    char** shape = (char**)malloc(height * sizeof(char*));
+    for (int i = 0; i < height; i++)
+    {
+        shape[i] = (char*)malloc((width + 1) * sizeof(char));
+        int length = (int)strlen(rows[i]);
+        memcpy(shape[i], rows[i], length);
+        memset(shape[i] + length, ' ', width - length);
+        shape[i][width] = '\0';
+    }
+    return shape;
+}
+
+void FreeShape(char** shape, int height)
+{
+    for (int i = 0; i < height; i++)
+    {
+        free(shape[i]);
+    }
+    free(shape);
+}
+
+// Parse the text of a settings file into a staged copy of the config, then commit it if there were no errors
+int ParseCfg(CFG* cfg, const char* filename, const char* text, size_t size, FILE* err)
+{
+    CFG_PARSER parser = { filename, err, 0 };
+    TIMING_CFG timing = *cfg->timing;
+    AREA_CFG area = *cfg->area;
+    FROG_CFG frog = *cfg->frog;
+    CARS_CFG cars = *cfg->cars;
+    CONTROLS_CFG controls = *cfg->controls;
+    CFG staged = { &timing, &area, &frog, &cars, &controls };
+    int setLine[N_CFG_SETTINGS] = { 0 };
+    char rows[2][CFG_MAX_SHAPE][CFG_MAX_SHAPE + 1];
+    char* shapes[2][CFG_MAX_SHAPE];
+    int shapeRows[2] = { -1, -1 };
+    int shapeLine[2] = { 0, 0 };
+    int section = -1;   // no header yet
+    int shape = -1;     // block being read
+
+    const char* end = text + size;
+    int lineNo = 0;
+    for (const char* line = text; line < end; )
+    {
+        const char* eol = (const char*)memchr(line, '\n', end - line);
+        eol = eol ? eol : end;
+        const char* next = eol < end ? eol + 1 : end;
+        int length = (int)(eol - line);
+        length -= length > 0 && line[length - 1] == '\r';
+        lineNo++;
+        int header = length >= 6 && strncmp(line, "---", 3) == 0 && strncmp(line + length - 3, "---", 3) == 0;
+
+        if (shape >= 0 && length > 0 && !header)
+        {
+            if (shapeRows[shape] == CFG_MAX_SHAPE || UnescapeShapeRow(line, length, rows[shape][shapeRows[shape]]) < 0)
+            {
+                CfgError(&parser, lineNo, 1, "%s is larger than %d x %d", CFG_SHAPE_KEYS[shape], CFG_MAX_SHAPE, CFG_MAX_SHAPE);
+            }
+            else
+            {
+                shapes[shape][shapeRows[shape]] = rows[shape][shapeRows[shape]];
+                shapeRows[shape]++;
+            }
+            line = next;
+            continue;
+        }
+        shape = -1;     // an empty line or a header ends the block
+        if (length == 0 || line[0] == '#')
+        {
+            line = next;
+            continue;
+        }
+
+        if (header)
+        {
+            section = -1;
+            for (int i = 0; i < CFG_SECTIONS; i++)
+            {
+                if ((int)strlen(CFG_SECTION_NAMES[i]) == length - 6 && strncmp(line + 3, CFG_SECTION_NAMES[i], length - 6) == 0)
+                {
+                    section = i;
+                }
+            }
+            if (section < 0)
+            {
+                CfgError(&parser, lineNo, 4, "unknown section %.*s", length - 6, line + 3);
+            }
+            line = next;
+            continue;
+        }
+
+        int block = -1;
+        for (int i = 0; i < 2; i++)
+        {
+            block = (int)strlen(CFG_SHAPE_KEYS[i]) == length && strncmp(line, CFG_SHAPE_KEYS[i], length) == 0 ? i : block;
+        }
+        const char* equals = (const char*)memchr(line, '=', length);
+        const CFG_SETTING* setting = NULL;
+        int index = -1;
+        for (int i = 0; i < N_CFG_SETTINGS && equals; i++)
+        {
+            if ((int)strlen(CFG_SETTINGS[i].name) == equals - line && strncmp(line, CFG_SETTINGS[i].name, equals - line) == 0)
+            {
+                setting = &CFG_SETTINGS[i];
+                index = i;
+            }
+        }
+        CfgSection expected = block >= 0 ? CFG_SHAPE_SECTIONS[block] : (setting ? setting->section : CFG_SECTIONS);
+        const char* name = block >= 0 ? CFG_SHAPE_KEYS[block] : (setting ? setting->name : NULL);
 
-    while (!feof(file)) {   // read config file and ovrride defaults
-        char section[20];
-        fscanf(file, "%s\n", section);
-        if (strcmp(section, "---TIMING---") == 0) {
-            LoadTimingFromFile(cfg->timing, file);
+        if (block < 0 && !setting)
+        {
+            CfgError(&parser, lineNo, 1, equals ? "unknown setting %.*s" : "expected KEY=VALUE, got %.*s",
+                equals ? (int)(equals - line) : length, line);
+        }
+        else if (section >= 0 && (int)expected != section)
+        {
+            CfgError(&parser, lineNo, 1, "%s belongs in ---%s---", name, CFG_SECTION_NAMES[expected]);
         }
-        else if (strcmp(section, "---AREA---") == 0) {
-            LoadAreaFromFile(cfg->area, file);
+        else if (block >= 0)
+        {
+            if (shapeRows[block] >= 0)
+            {
+                CfgError(&parser, lineNo, 1, "%s is already given on line %d", name, shapeLine[block]);
+            }
+            shape = block;
+            shapeRows[block] = 0;
+            shapeLine[block] = lineNo;
         }
-        else if (strcmp(section, "---FROG---") == 0) {
-            LoadFrogFromFile(cfg->frog, file);
+        else if (setLine[index])
+        {
+            CfgError(&parser, lineNo, 1, "%s is already set on line %d", name, setLine[index]);
         }
-        else if (strcmp(section, "---CARS---") == 0) {
-            LoadCarsFromFile(cfg->cars, file);
+        else
+        {
+            const char* value = equals + 1;
+            int valueLength = length - (int)(value - line);
+            int column = (int)(value - line) + 1;
+            int number;
+            int parsed;
+            setLine[index] = lineNo;
+            if (setting->key && valueLength == 1)
+            {
+                *CfgField(&staged, setting) = (unsigned char)value[0];
+            }
+            else if ((parsed = ParseCfgInt(value, valueLength, &number)) == 0)
+            {
+                CfgError(&parser, lineNo, column, setting->key ? "%s takes a character or a key code" : "%s takes a number", name);
+            }
+            else if (parsed < 0)
+            {
+                CfgError(&parser, lineNo, column, "%s value out of range", name);
+            }
+            else if (number < setting->min || number > setting->max)
+            {
+                CfgError(&parser, lineNo, column, "%s must be between %d and %d", name, setting->min, setting->max);
+            }
+            else
+            {
+                *CfgField(&staged, setting) = number;
+            }
         }
-        else if (strcmp(section, "---CONTROLS---") == 0) {
-            LoadControlsFromFile(cfg->controls, file);
+        line = next;
+    }
+
+    // settings that depend on each other
+    int frogShape = shapeRows[0] >= 0;
+    int carShape = shapeRows[1] >= 0;
+    CheckShape(&parser, frogShape ? shapes[0] : cfg->frog->shape, frogShape ? shapeRows[0] : cfg->frog->height,
+        shapeLine[0], "FROG_SHAPE", frog.width, frog.height);
+    CheckShape(&parser, carShape ? shapes[1] : cfg->cars->shape, carShape ? shapeRows[1] : cfg->cars->height,
+        shapeLine[1], "CAR_SHAPE", cars.width, cars.height);
+    if (area.playableRows < frog.height + 2 || area.cols < frog.width + 2)
+    {
+        CfgError(&parser, 0, 0, "the area of %d x %d is too small for the frog and its border", area.playableRows, area.cols);
+    }
+    int keys[5] = { controls.up, controls.down, controls.left, controls.right, controls.quit };
+    for (int i = 0; i < 5; i++)
+    {
+        for (int j = i + 1; j < 5; j++)
+        {
+            if (keys[i] == keys[j])
+            {
+                CfgError(&parser, setLine[N_CFG_SETTINGS - 5 + j], 1, "%s and %s are the same key",
+                    CFG_SETTINGS[N_CFG_SETTINGS - 5 + i].name, CFG_SETTINGS[N_CFG_SETTINGS - 5 + j].name);
+            }
         }
     }
+    if (parser.errors > 0)
+    {
+        return -1;
+    }
+
+    char** frogRows = frogShape ? CopyShape(shapes[0], frog.width, frog.height) : cfg->frog->shape;
+    char** carRows = carShape ? CopyShape(shapes[1], cars.width, cars.height) : cfg->cars->shape;
+    if (frogShape)
+    {
+        FreeShape(cfg->frog->shape, cfg->frog->height);
+    }
+    if (carShape)
+    {
+        FreeShape(cfg->cars->shape, cfg->cars->height);
+    }
+    frog.shape = frogRows;
+    cars.shape = carRows;
+    *cfg->timing = timing;
+    *cfg->area = area;
+    *cfg->frog = frog;
+    *cfg->cars = cars;
+    *cfg->controls = controls;
+    return 0;
+}
 
-    fclose(file);
+int LoadCfgFromFile(CFG* cfg, const char* filename, FILE* err)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;   // no file - the values stay
+    }
+    struct stat info;
+    void* text = NULL;
+    if (fstat(fd, &info) != 0 ||
+        (info.st_size > 0 && (text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED))
+    {
+        close(fd);
+        fprintf(err, "%s: cannot read the file\n", filename);
+        return -1;
+    }
+    close(fd);
+    int status = ParseCfg(cfg, filename, text ? (const char*)text : "", text ? info.st_size : 0, err);
+    if (text)
+    {
+        munmap(text, info.st_size);
+    }
+    return status;
 }
 
-// Config initializer
 CFG* InitCfg()
 {
-    const char* filename = "settings.txt";  // default config file
     CFG* cfg = (CFG*)malloc(sizeof(CFG));
     LoadCfgDefaults(cfg);
-    LoadCfgFromFile(cfg, filename);
+    if (LoadCfgFromFile(cfg, CFG_FILE, stderr) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
     return cfg;
-}
\ No newline at end of file
+}
+
+void FreeCfg(CFG* cfg)
+{
+    FreeShape(cfg->frog->shape, cfg->frog->height);
+    FreeShape(cfg->cars->shape, cfg->cars->height);
+    free(cfg->timing);
+    free(cfg->area);
+    free(cfg->frog);
+    free(cfg->cars);
+    free(cfg->controls);
+    free(cfg);
+}
+
+int SameShape(char** shape, char** other, int height)
+{
+    for (int i = 0; i < height; i++)
+    {
+        if (strcmp(shape[i], other[i]) != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int SameWorld(CFG* cfg, CFG* other)
+{
+    return cfg->area->playableRows == other->area->playableRows && cfg->area->cols == other->area->cols &&
+        cfg->area->endless == other->area->endless &&
+        cfg->frog->width == other->frog->width && cfg->frog->height == other->frog->height &&
+        SameShape(cfg->frog->shape, other->frog->shape, cfg->frog->height) &&
+        cfg->cars->nCars == other->cars->nCars && cfg->cars->width == other->cars->width &&
+        cfg->cars->height == other->cars->height && SameShape(cfg->cars->shape, other->cars->shape, cfg->cars->height);
+}
+
+
+// --- CONFIGURATION HASH ---
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t HashShape(uint64_t hash, char** shape, int height)
+{
+    for (int i = 0; i < height; i++)
+    {
+        hash = HashBytes(hash, shape[i], strlen(shape[i]) + 1);
+    }
+    return hash;
+}
+
+uint64_t HashCfg(CFG* cfg)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = HashBytes(hash, cfg->timing, sizeof(TIMING_CFG));
+    hash = HashBytes(hash, cfg->area, sizeof(AREA_CFG));
+    hash = HashBytes(hash, &cfg->frog->moveFactor, sizeof(int));
+    hash = HashBytes(hash, &cfg->frog->width, sizeof(int));
+    hash = HashBytes(hash, &cfg->frog->height, sizeof(int));
+    hash = HashShape(hash, cfg->frog->shape, cfg->frog->height);
+    hash = HashBytes(hash, &cfg->cars->nCars, sizeof(int));
+    hash = HashBytes(hash, &cfg->cars->moveFactor, sizeof(int));
+    hash = HashBytes(hash, &cfg->cars->width, sizeof(int));
+    hash = HashBytes(hash, &cfg->cars->height, sizeof(int));
+    hash = HashShape(hash, cfg->cars->shape, cfg->cars->height);
+    hash = HashBytes(hash, cfg->controls, sizeof(CONTROLS_CFG));
+    return hash;
+}
@@ -2,6 +2,12 @@
 #ifndef CFG_H
 #define CFG_H
 
+#include <stdio.h>
+#include <stdint.h>
+
+#define CFG_FILE "settings.txt"     // default config file
+#define CFG_MAX_SHAPE 64            // rows and columns of a shape
+
 // --- CFG STRUCTURES ---
 // Timing
 typedef struct {
@@ -12,11 +18,12 @@ typedef struct {
 
 // Area
 typedef struct {
-    int playableRows;
+    int playableRows;   // rows of the world - the window shows as many as fit in the terminal
     int statusRows;
     int cols;
     int offy;
     int offx;
+    int endless;        // 1 for the endless road - lanes are generated ahead of the frog and recycled behind it
 } AREA_CFG;
 
 // Frog
@@ -54,6 +61,25 @@ typedef struct {
     CONTROLS_CFG* controls;
 } CFG;
 
+// Sections of the settings file, in CFG order
+typedef enum {
+    SECTION_TIMING,
+    SECTION_AREA,
+    SECTION_FROG,
+    SECTION_CARS,
+    SECTION_CONTROLS,
+    CFG_SECTIONS
+} CfgSection;
+
+// Integer setting of the settings file - a field of its section's structure
+typedef struct {
+    const char* name;
+    CfgSection section;
+    size_t offset;      // of the int in the section's structure
+    int min, max;
+    int key;            // 1 for a control key - a single character or a key code
+} CFG_SETTING;
+
 // --- CFG FUNCTIONS ---
 // Load default values for each configuration section
 void LoadTimingDefaults(TIMING_CFG* timing);
@@ -63,13 +89,20 @@ void LoadCarsDefaults(CARS_CFG* cars);
 void LoadControlsDefaults(CONTROLS_CFG* controls);
 void LoadCfgDefaults(CFG* cfg);
 
-// Load configuration from file for each section
-void LoadTimingFromFile(TIMING_CFG* timing, FILE* file);
-void LoadAreaFromFile(AREA_CFG* area, FILE* file);
-void LoadFrogFromFile(FROG_CFG* frog, FILE* file);
-void LoadCarsFromFile(CARS_CFG* cars, FILE* file);
-void LoadControlsFromFile(CONTROLS_CFG* controls, FILE* file);
-void LoadCfgFromFile(CFG* cfg, const char* filename);
+// Load the settings file over the values in cfg - one pass over the mapped file, keys in any order within their
+// sections, shapes as FROG_SHAPE:/CAR_SHAPE: blocks of rows (up to an empty line), controls as characters or key codes
+// 0 on success (also when there is no file), -1 on error (reported to err with the line and column) - cfg is unchanged then
+int LoadCfgFromFile(CFG* cfg, const char* filename, FILE* err);
+// Integer setting of the settings file by its key, NULL if there is none - its range is the one the parser checks
+const CFG_SETTING* FindCfgSetting(const char* name);
+// Defaults overridden by CFG_FILE - exits on errors in the file
 CFG* InitCfg();
+void FreeCfg(CFG* cfg);
+// Same world - what a running game cannot change without starting again (cars, shapes, area), 1 if equal
+int SameWorld(CFG* cfg, CFG* other);
+// Fingerprint of all settings - recordings only replay with the config they were made with
+uint64_t HashCfg(CFG* cfg);
+// FNV-1a over the bytes of a value, continuing from hash
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size);
 
 #endif // CFG_H
\ No newline at end of file
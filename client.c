@@ -0,0 +1,224 @@
+// client.c
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "client.h"
+
+
+// --- CLIENT FUNCTIONS ---
+int SendMessage(CONNECTION* connection, MessageType type, int value)
+{
+    unsigned char message[2] = { (unsigned char)type, (unsigned char)value };
+    ssize_t n;
+    while ((n = send(connection->fd, message, sizeof(message), MSG_NOSIGNAL)) < 0 && errno == EINTR);
+    return n == sizeof(message) ? 0 : -1;
+}
+
+CONNECTION* Connect(const char* path, int spectate)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        return NULL;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    CONNECTION* connection = (CONNECTION*)malloc(sizeof(CONNECTION));
+    memset(connection, 0, sizeof(CONNECTION));
+    connection->fd = fd;
+    connection->player = NET_SPECTATOR;
+    connection->result = RUNNING;
+    connection->frogs = (OBJ*)calloc(NET_MAX_FROGS, sizeof(OBJ));
+    for (int i = 0; i < NET_MAX_FROGS; i++)
+    {
+        connection->frogs[i].y = NET_GONE;
+    }
+    if (SendMessage(connection, MSG_HELLO, spectate ? 1 : 0) != 0)
+    {
+        Disconnect(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+// Apply a tick - positions of the cars and frogs that have moved
+void ApplyTick(CONNECTION* connection, SIM* mirror, const unsigned char* payload, size_t size)
+{
+    TICK_HEADER header;
+    if (size < sizeof(header))
+    {
+        return;
+    }
+    memcpy(&header, payload, sizeof(header));
+    if (sizeof(header) + header.nCars * 4 + header.nFrogs * 6 > size)
+    {
+        return;
+    }
+    const unsigned char* entry = payload + sizeof(header);
+    CAR_POOL* cars = mirror->cars;
+    for (int i = 0; i < header.nCars; i++, entry += 4)
+    {
+        uint16_t car;
+        int16_t x;
+        memcpy(&car, entry, 2);
+        memcpy(&x, entry + 2, 2);
+        if (car < cars->count)
+        {
+            cars->x[car] = x;
+        }
+    }
+    if (header.full)
+    {
+        for (int i = 0; i < NET_MAX_FROGS; i++)
+        {
+            connection->frogs[i].y = NET_GONE;
+        }
+        mirror->frog->y = NET_GONE;
+    }
+    for (int i = 0; i < header.nFrogs; i++, entry += 6)
+    {
+        uint16_t id;
+        int16_t x, y;
+        memcpy(&id, entry, 2);
+        memcpy(&x, entry + 2, 2);
+        memcpy(&y, entry + 4, 2);
+        if (id >= NET_MAX_FROGS)
+        {
+            continue;
+        }
+        OBJ* frog = id == connection->player ? mirror->frog : &connection->frogs[id];
+        frog->x = x;
+        frog->y = y;
+        if (id == connection->player && y != NET_GONE)
+        {
+            connection->result = RUNNING;   // on the road again - a new round
+        }
+    }
+    mirror->timer->frameNo = header.frame;
+    mirror->timer->timeLeft = header.timeLeft;
+    mirror->dest->x = header.destX;
+    mirror->dest->y = header.destY;
+    connection->ticks++;
+}
+
+// Parse the complete messages received so far - the number of ticks among them
+int ParseMessages(CONNECTION* connection, SIM* mirror)
+{
+    int ticks = 0;
+    size_t used = 0;
+    while (connection->in.size - used >= NET_HEADER)
+    {
+        uint32_t length;
+        memcpy(&length, connection->in.data + used, sizeof(length));
+        if (length == 0 || length > NET_MAX_MESSAGE)
+        {
+            return -1;
+        }
+        if (connection->in.size - used < sizeof(length) + length)
+        {
+            break;
+        }
+        int type = connection->in.data[used + sizeof(length)];
+        const unsigned char* payload = connection->in.data + used + NET_HEADER;
+        size_t size = length - 1;
+        if (type == MSG_WELCOME && size >= sizeof(uint64_t) + 4)
+        {
+            uint16_t player, nCars;
+            memcpy(&connection->cfgHash, payload, sizeof(uint64_t));
+            memcpy(&player, payload + sizeof(uint64_t), 2);
+            memcpy(&nCars, payload + sizeof(uint64_t) + 2, 2);
+            connection->player = player;
+            connection->nCars = nCars;
+            connection->welcomed = 1;
+        }
+        else if (type == MSG_TICK && mirror)
+        {
+            ApplyTick(connection, mirror, payload, size);
+            ticks++;
+        }
+        else if (type == MSG_RESULT && size >= 1)
+        {
+            connection->result = payload[0];
+        }
+        used += sizeof(length) + length;
+        if (!mirror && connection->welcomed)
+        {
+            break;  // the ticks wait for the mirror game
+        }
+    }
+    ConsumeBytes(&connection->in, used);
+    return ticks;
+}
+
+// Read what the socket has without blocking - 0 when the server has closed the connection
+int ReadSocket(CONNECTION* connection)
+{
+    unsigned char chunk[4096];
+    while (1)
+    {
+        ssize_t n = recv(connection->fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return 1;
+        }
+        if (n <= 0)
+        {
+            return 0;
+        }
+        PutBytes(&connection->in, chunk, n);
+        connection->bytes += n;
+    }
+}
+
+int AwaitWelcome(CONNECTION* connection, CFG* cfg, int timeout)
+{
+    struct pollfd fd = { connection->fd, POLLIN, 0 };
+    while (!connection->welcomed)
+    {
+        if (poll(&fd, 1, timeout) <= 0 || !ReadSocket(connection) || ParseMessages(connection, NULL) < 0)
+        {
+            return -1;
+        }
+    }
+    return connection->cfgHash == HashCfg(cfg) && connection->nCars == cfg->cars->nCars ? 0 : -1;
+}
+
+int ReceiveState(CONNECTION* connection, SIM* mirror)
+{
+    int open = ReadSocket(connection);
+    int ticks = ParseMessages(connection, mirror);
+    return open && ticks >= 0 ? ticks : -1;
+}
+
+int SendKey(CONNECTION* connection, int key)
+{
+    return key >= 0 && key < 256 ? SendMessage(connection, MSG_KEY, key) : 0;   // the controls are single bytes
+}
+
+void Disconnect(CONNECTION* connection)
+{
+    close(connection->fd);
+    FreeBuffer(&connection->in);
+    free(connection->frogs);
+    free(connection);
+}
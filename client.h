@@ -0,0 +1,35 @@
+// client.h
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdio.h>
+#include "sim.h"
+#include "net.h"
+
+// Connection of a thin client - it simulates nothing, the received state is written into a mirror game for the renderer
+typedef struct {
+    int fd;
+    int welcomed;       // 1 once the server has answered HELLO
+    uint64_t cfgHash;   // of the server's config
+    int player;         // own id, NET_SPECTATOR for a spectator
+    int nCars;
+    NET_BUFFER in;      // received bytes not parsed yet
+    OBJ* frogs;         // NET_MAX_FROGS frogs of the other players, y is NET_GONE when not on the road
+    int result;         // GameResult of the own round, RUNNING while the frog is on the road
+    long ticks;
+    long bytes;         // received
+} CONNECTION;
+
+// --- CLIENT FUNCTIONS ---
+// Connect to the server at path and say HELLO - NULL on error
+CONNECTION* Connect(const char* path, int spectate);
+// Wait for the WELCOME (up to timeout milliseconds) - 0 if the server runs the same config
+int AwaitWelcome(CONNECTION* connection, CFG* cfg, int timeout);
+// Read what the server has sent and apply it to the mirror game - the number of ticks applied, -1 when the server is gone
+// The mirror is a game of the same config that is never stepped, so its cars are always in sync and only written here
+int ReceiveState(CONNECTION* connection, SIM* mirror);
+// 0 if the key has been sent
+int SendKey(CONNECTION* connection, int key);
+void Disconnect(CONNECTION* connection);
+
+#endif // CLIENT_H
@@ -0,0 +1,227 @@
+// env.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "env.h"
+
+
+// --- GAMES ---
+// Start the next episode of game i in its arena
+void StartEpisode(VEC_ENV* env, int i)
+{
+    ResetArena(env->arenas[i]);
+    env->sims[i] = InitSim(env->cfg, env->sprites, DeriveSeed(env->seed, (uint64_t)i << 32 | env->episodes[i]++), env->arenas[i]);
+}
+
+// Fill a box of cells, clipped to the observation
+void FillCells(VEC_ENV* env, uint8_t* obs, int x, int y, int width, int height, EnvCell cell)
+{
+    int xmin = x > 0 ? x : 0;
+    int xmax = x + width < env->cols ? x + width : env->cols;
+    int ymin = y > 0 ? y : 0;
+    int ymax = y + height < env->rows ? y + height : env->rows;
+    for (int row = ymin; row < ymax && xmin < xmax; row++)
+    {
+        memset(obs + (size_t)row * env->cols + xmin, cell, xmax - xmin);
+    }
+}
+
+// Observation of a game - the destination, the cars and the frog as boxes of cells
+void Observe(VEC_ENV* env, SIM* sim, uint8_t* obs)
+{
+    CAR_POOL* cars = sim->cars;
+    memset(obs, CELL_EMPTY, VecEnvObsSize(env));
+    FillCells(env, obs, sim->dest->x, sim->dest->y, sim->dest->width, sim->dest->height, CELL_DEST);
+    SyncCars(cars, 0, cars->count);
+    for (int i = 0; i < cars->count; i++)
+    {
+        FillCells(env, obs, cars->x[i], cars->y[i], cars->width, cars->height, CELL_CAR);
+    }
+    FillCells(env, obs, sim->frog->x, sim->frog->y, sim->frog->width, sim->frog->height, CELL_FROG);
+}
+
+void ResetVecEnvRange(VEC_ENV* env, int from, int to, uint8_t* obs)
+{
+    for (int i = from; i < to; i++)
+    {
+        StartEpisode(env, i);
+        Observe(env, env->sims[i], obs + (size_t)i * VecEnvObsSize(env));
+    }
+}
+
+void StepVecEnvRange(VEC_ENV* env, int from, int to, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones, int32_t* results)
+{
+    for (int i = from; i < to; i++)
+    {
+        int action = actions[i];
+        GameResult result = StepSim(env->sims[i], action > ACTION_NONE && action < ENV_ACTIONS ? env->keys[action] : NO_KEY);
+        rewards[i] = result == SUCCESS ? ENV_REWARD_SUCCESS : (result == FAILURE ? ENV_REWARD_FAILURE : 0.0f);
+        dones[i] = result != RUNNING;
+        if (results)
+        {
+            results[i] = result;
+        }
+        if (result != RUNNING)
+        {
+            StartEpisode(env, i);
+        }
+        Observe(env, env->sims[i], obs + (size_t)i * VecEnvObsSize(env));
+    }
+}
+
+
+// --- THREADS ---
+// Games of a thread - contiguous ranges, so that the observations of a thread are contiguous as well
+void ThreadRange(VEC_ENV* env, int thread, int* from, int* to)
+{
+    *from = (int)((long)env->n * thread / env->nThreads);
+    *to = (int)((long)env->n * (thread + 1) / env->nThreads);
+}
+
+// Run the call in progress on the games of a thread
+void RunRange(VEC_ENV* env, int thread)
+{
+    int from, to;
+    ThreadRange(env, thread, &from, &to);
+    if (env->actions)
+    {
+        StepVecEnvRange(env, from, to, env->actions, env->obs, env->rewards, env->dones, env->results);
+    }
+    else
+    {
+        ResetVecEnvRange(env, from, to, env->obs);
+    }
+}
+
+typedef struct {
+    VEC_ENV* env;
+    int thread;
+} ENV_WORKER;
+
+void* EnvWorker(void* arg)
+{
+    ENV_WORKER worker = *(ENV_WORKER*)arg;
+    free(arg);
+    VEC_ENV* env = worker.env;
+    while (1)
+    {
+        pthread_barrier_wait(&env->start);
+        if (env->stop)
+        {
+            return NULL;
+        }
+        RunRange(env, worker.thread);
+        pthread_barrier_wait(&env->done);
+    }
+}
+
+// Run the call set up in the env on all threads - the caller's thread takes range 0
+void RunAll(VEC_ENV* env)
+{
+    if (env->nThreads > 1)
+    {
+        pthread_barrier_wait(&env->start);
+        RunRange(env, 0);
+        pthread_barrier_wait(&env->done);
+    }
+    else
+    {
+        RunRange(env, 0);
+    }
+}
+
+
+// --- VEC ENV FUNCTIONS ---
+VEC_ENV* InitVecEnv(const char* settings, int n, uint64_t seed, int threads)
+{
+    VEC_ENV* env = (VEC_ENV*)calloc(1, sizeof(VEC_ENV));
+    env->cfg = (CFG*)malloc(sizeof(CFG));
+    LoadCfgDefaults(env->cfg);
+    if (settings && LoadCfgFromFile(env->cfg, settings, stderr) != 0)
+    {
+        FreeCfg(env->cfg);
+        free(env);
+        return NULL;
+    }
+    env->cfg->area->endless = 0;    // episodes end at the destination
+    env->sprites = InitSpriteAtlas(env->cfg);
+    env->n = n;
+    env->rows = env->cfg->area->playableRows;
+    env->cols = env->cfg->area->cols;
+    env->seed = seed;
+    env->arenas = (ARENA**)malloc(n * sizeof(ARENA*));
+    env->sims = (SIM**)malloc(n * sizeof(SIM*));
+    env->episodes = (uint32_t*)calloc(n, sizeof(uint32_t));
+    for (int i = 0; i < n; i++)
+    {
+        env->arenas[i] = InitArena(SimArenaSize(env->cfg));
+        StartEpisode(env, i);
+    }
+    CONTROLS_CFG* controls = env->cfg->controls;
+    int keys[ENV_ACTIONS] = { NO_KEY, controls->up, controls->down, controls->left, controls->right };
+    memcpy(env->keys, keys, sizeof(keys));
+
+    env->nThreads = threads < 1 ? 1 : (threads > n && n > 0 ? n : threads);
+    if (env->nThreads > 1)
+    {
+        pthread_barrier_init(&env->start, NULL, env->nThreads);
+        pthread_barrier_init(&env->done, NULL, env->nThreads);
+        env->threads = (pthread_t*)malloc(env->nThreads * sizeof(pthread_t));
+        for (int t = 1; t < env->nThreads; t++)
+        {
+            ENV_WORKER* worker = (ENV_WORKER*)malloc(sizeof(ENV_WORKER));
+            worker->env = env;
+            worker->thread = t;
+            pthread_create(&env->threads[t], NULL, EnvWorker, worker);
+        }
+    }
+    return env;
+}
+
+size_t VecEnvObsSize(VEC_ENV* env)
+{
+    return (size_t)env->rows * env->cols;
+}
+
+void ResetVecEnv(VEC_ENV* env, uint8_t* obs)
+{
+    env->actions = NULL;
+    env->obs = obs;
+    RunAll(env);
+}
+
+void StepVecEnv(VEC_ENV* env, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones, int32_t* results)
+{
+    env->actions = actions;
+    env->obs = obs;
+    env->rewards = rewards;
+    env->dones = dones;
+    env->results = results;
+    RunAll(env);
+}
+
+void FreeVecEnv(VEC_ENV* env)
+{
+    if (env->nThreads > 1)
+    {
+        env->stop = 1;
+        pthread_barrier_wait(&env->start);
+        for (int t = 1; t < env->nThreads; t++)
+        {
+            pthread_join(env->threads[t], NULL);
+        }
+        pthread_barrier_destroy(&env->start);
+        pthread_barrier_destroy(&env->done);
+        free(env->threads);
+    }
+    for (int i = 0; i < env->n; i++)
+    {
+        FreeArena(env->arenas[i]);
+    }
+    free(env->arenas);
+    free(env->sims);
+    free(env->episodes);
+    FreeSpriteAtlas(env->sprites);
+    FreeCfg(env->cfg);
+    free(env);
+}
@@ -0,0 +1,76 @@
+// env.h
+#ifndef ENV_H
+#define ENV_H
+
+#include <pthread.h>
+#include "sim.h"
+
+// Vectorized environment - the game as a library for training agents (build.sh --lib builds it as a shared library)
+// A step moves every game of the batch by one frame; observations, rewards and dones are written into arrays owned
+// by the caller, contiguous per game. Nothing is allocated after InitVecEnv: a finished game is restarted in its own
+// arena, in the same step (the observation is the first one of the new episode)
+
+// --- CONSTANTS ---
+// Actions - index into the keys of the controls
+typedef enum {
+    ACTION_NONE,
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ENV_ACTIONS
+} EnvAction;
+
+// Cells of an observation - one byte per cell of the playable area, rows x cols, later ones drawn over earlier ones
+typedef enum {
+    CELL_EMPTY,
+    CELL_DEST,
+    CELL_CAR,
+    CELL_FROG
+} EnvCell;
+
+#define ENV_REWARD_SUCCESS 1.0f
+#define ENV_REWARD_FAILURE (-1.0f)  // the frog has been hit - running out of time is worth nothing
+
+
+// --- DATA STRUCTURES ---
+// Batch of games - game i owns its arena, the config and the sprites are shared and read-only
+typedef struct VEC_ENV {
+    CFG* cfg;
+    SPRITE_ATLAS* sprites;
+    int n;                  // games in the batch
+    int rows, cols;         // of one observation
+    uint64_t seed;
+    ARENA** arenas;
+    SIM** sims;
+    uint32_t* episodes;     // started so far per game - episode e of game i is seeded with DeriveSeed(seed, i << 32 | e)
+    int keys[ENV_ACTIONS];
+    // worker threads - each steps a fixed range of the games, the caller's thread takes the first one
+    int nThreads;
+    pthread_t* threads;
+    pthread_barrier_t start, done;
+    int stop;
+    const int32_t* actions; // arguments of the step in progress, NULL actions for a reset
+    uint8_t* obs;
+    float* rewards;
+    uint8_t* dones;
+    int32_t* results;
+} VEC_ENV;
+
+
+// --- VEC ENV FUNCTIONS ---
+// Batch of n games of the config in the settings file (the defaults for NULL), stepped on the given number of threads
+// NULL if the settings file has errors - they are reported on stderr
+VEC_ENV* InitVecEnv(const char* settings, int n, uint64_t seed, int threads);
+// Bytes of one observation - rows x cols
+size_t VecEnvObsSize(VEC_ENV* env);
+// Start a new episode in every game - n observations into obs
+void ResetVecEnv(VEC_ENV* env, uint8_t* obs);
+// Step every game with its action - n observations, rewards and dones (1 when the episode has ended in this step)
+// results gets the GameResult of every game (RUNNING while it goes on), it may be NULL
+void StepVecEnv(VEC_ENV* env, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones, int32_t* results);
+// Games [from, to) only - calls for disjoint ranges may run on threads of the caller's own
+void StepVecEnvRange(VEC_ENV* env, int from, int to, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones, int32_t* results);
+void FreeVecEnv(VEC_ENV* env);
+
+#endif // ENV_H
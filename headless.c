@@ -0,0 +1,98 @@
+// headless.c
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "headless.h"
+
+
+// --- HEADLESS FUNCTIONS ---
+int HeadlessKey(SIM* sim, RNG* rng)
+{
+    CONTROLS_CFG* controls = sim->cfg->controls;
+    OBJ* frog = sim->frog;
+    if (RandInt(rng, 0, 15) == 0)    // random hop to the side to vary the games
+    {
+        return RandInt(rng, 0, 1) ? controls->left : controls->right;
+    }
+    if (frog->x != sim->dest->x)
+    {
+        return frog->x < sim->dest->x ? controls->right : controls->left;
+    }
+
+    // wait if a car is near the row above
+    if (CollideLanes(sim->lanes, sim->cars, frog->x - HEADLESS_MARGIN, frog->y - 1, frog->width + 2 * HEADLESS_MARGIN, frog->height) >= 0)
+    {
+        return NO_KEY;
+    }
+    return controls->up;
+}
+
+GameResult PlayHeadless(SIM* sim, RNG* rng, int* frames)
+{
+    GameResult result = RUNNING;
+    int frame = 0;
+    while (result == RUNNING)
+    {
+        result = StepSim(sim, HeadlessKey(sim, rng));
+        frame++;
+    }
+    *frames = frame;
+    return result;
+}
+
+void PlayHeadlessGame(CFG* cfg, SPRITE_ATLAS* sprites, ARENA* arena, uint64_t seed, HEADLESS_STATS* stats)
+{
+    SIM* sim = InitSim(cfg, sprites, seed, arena);
+    sim->viewRows = 0;  // nothing is drawn - only the cars around the frog are stepped every frame
+    RNG bot;    // the bot's choices must not disturb the game's own randomness
+    SeedRng(&bot, DeriveSeed(seed, 0));
+    int frames;
+    GameResult result = PlayHeadless(sim, &bot, &frames);
+    stats->games++;
+    stats->results[result]++;
+    stats->frames += frames;
+    stats->distance += cfg->area->endless ? SimDistance(sim) : 0;
+    if (result == SUCCESS)
+    {
+        stats->successFrames += frames;
+    }
+    ResetArena(arena);
+}
+
+void RunHeadless(CFG* cfg, int games, uint64_t seed, HEADLESS_STATS* stats)
+{
+    memset(stats, 0, sizeof(HEADLESS_STATS));
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    ARENA* arena = InitArena(SimArenaSize(cfg));   // reused by every game
+    for (int i = 0; i < games; i++)
+    {
+        PlayHeadlessGame(cfg, sprites, arena, DeriveSeed(seed, i), stats);
+    }
+    FreeArena(arena);
+    FreeSpriteAtlas(sprites);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+void PrintHeadlessStats(HEADLESS_STATS* stats, FILE* out)
+{
+    fprintf(out, "games: %d\n", stats->games);
+    fprintf(out, "success: %d\n", stats->results[SUCCESS]);
+    fprintf(out, "failure: %d\n", stats->results[FAILURE]);
+    fprintf(out, "time over: %d\n", stats->results[TIME_OVER]);
+    fprintf(out, "frames: %ld (%.1f per game)\n", stats->frames, stats->games ? (double)stats->frames / stats->games : 0.0);
+    if (stats->results[SUCCESS] > 0)
+    {
+        fprintf(out, "frames to finish: %.1f\n", (double)stats->successFrames / stats->results[SUCCESS]);
+    }
+    if (stats->distance > 0)
+    {
+        fprintf(out, "distance: %.1f rows per game\n", stats->games ? (double)stats->distance / stats->games : 0.0);
+    }
+    if (stats->seconds > 0)
+    {
+        fprintf(out, "games/s: %.0f\n", stats->games / stats->seconds);
+    }
+}
@@ -0,0 +1,30 @@
+// headless.h
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "sim.h"
+
+#define HEADLESS_MARGIN 16   // columns kept clear on both sides before jumping into a lane
+
+// Aggregated results of a series of headless games
+typedef struct {
+    int games;
+    int results[INTERRUPTED + 1];   // number of games per GameResult
+    long frames;                    // frames played in total
+    long successFrames;             // frames played in games that ended with SUCCESS
+    long distance;                  // rows climbed in total on the endless road
+    double seconds;                 // wall time spent
+} HEADLESS_STATS;
+
+// --- HEADLESS FUNCTIONS ---
+// Input of a simple bot - heads for the destination, waits for cars closer than the margin
+int HeadlessKey(SIM* sim, RNG* rng);
+// Play a single game without a terminal, as fast as possible
+GameResult PlayHeadless(SIM* sim, RNG* rng, int* frames);
+// Play one game in the arena (reset afterwards) and add it to the statistics
+void PlayHeadlessGame(CFG* cfg, SPRITE_ATLAS* sprites, ARENA* arena, uint64_t seed, HEADLESS_STATS* stats);
+// Play a number of games and collect the statistics - game i is seeded with DeriveSeed(seed, i)
+void RunHeadless(CFG* cfg, int games, uint64_t seed, HEADLESS_STATS* stats);
+void PrintHeadlessStats(HEADLESS_STATS* stats, FILE* out);
+
+#endif // HEADLESS_H
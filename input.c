@@ -0,0 +1,145 @@
+// input.c
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "input.h"
+#include "pacer.h"
+
+
+// --- RING FUNCTIONS ---
+// Producer side - 0 if the ring is full
+int PushInput(INPUT_RING* ring, int key, int64_t time)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == INPUT_RING_SIZE)
+    {
+        return 0;
+    }
+    INPUT_EVENT* event = &ring->events[head & (INPUT_RING_SIZE - 1)];
+    event->key = key;
+    event->time = time;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);    // publishes the event
+    return 1;
+}
+
+int PeekInput(INPUT_THREAD* input, INPUT_EVENT* event)
+{
+    INPUT_RING* ring = &input->ring;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head)
+    {
+        return 0;
+    }
+    *event = ring->events[tail & (INPUT_RING_SIZE - 1)];
+    return 1;
+}
+
+void PopInput(INPUT_THREAD* input)
+{
+    INPUT_RING* ring = &input->ring;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);    // hands the slot back to the producer
+}
+
+void ClearInputReady(INPUT_THREAD* input)
+{
+    char buffer[64];
+    while (read(input->ready[0], buffer, sizeof(buffer)) > 0);
+}
+
+
+// --- INPUT THREAD ---
+void* RunInput(void* arg)
+{
+    INPUT_THREAD* input = (INPUT_THREAD*)arg;
+    struct pollfd fds[2] = { { input->fd, POLLIN, 0 }, { input->wake[0], POLLIN, 0 } };
+    unsigned char buffer[64];
+    while (1)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents)
+        {
+            break;  // stopped
+        }
+        if (!fds[0].revents)
+        {
+            continue;
+        }
+        ssize_t n = read(input->fd, buffer, sizeof(buffer));
+        int64_t time = NowNs();
+        if (n <= 0)
+        {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            {
+                continue;
+            }
+            break;  // end of input
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (!PushInput(&input->ring, buffer[i], time))
+            {
+                atomic_fetch_add_explicit(&input->dropped, 1, memory_order_relaxed);
+            }
+        }
+        char ready = 0;
+        while (write(input->ready[1], &ready, 1) < 0 && errno == EINTR);   // a full pipe already wakes the game loop
+    }
+    return NULL;
+}
+
+INPUT_THREAD* StartInputThread(int fd)
+{
+    INPUT_THREAD* input = (INPUT_THREAD*)aligned_alloc(64, sizeof(INPUT_THREAD));
+    atomic_init(&input->ring.head, 0);
+    atomic_init(&input->ring.tail, 0);
+    atomic_init(&input->dropped, 0);
+    input->fd = fd;
+    if (pipe(input->wake) != 0)
+    {
+        free(input);
+        return NULL;
+    }
+    if (pipe(input->ready) != 0)
+    {
+        close(input->wake[0]);
+        close(input->wake[1]);
+        free(input);
+        return NULL;
+    }
+    fcntl(input->ready[0], F_SETFL, O_NONBLOCK);
+    fcntl(input->ready[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&input->thread, NULL, RunInput, input) != 0)
+    {
+        close(input->wake[0]);
+        close(input->wake[1]);
+        close(input->ready[0]);
+        close(input->ready[1]);
+        free(input);
+        return NULL;
+    }
+    return input;
+}
+
+void StopInputThread(INPUT_THREAD* input)
+{
+    char stop = 0;
+    while (write(input->wake[1], &stop, 1) < 0 && errno == EINTR);
+    pthread_join(input->thread, NULL);
+    close(input->wake[0]);
+    close(input->wake[1]);
+    close(input->ready[0]);
+    close(input->ready[1]);
+    free(input);
+}
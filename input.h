@@ -0,0 +1,46 @@
+// input.h
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define INPUT_RING_SIZE 256     // queued key presses, power of 2
+
+// Key press with the time it was read (NowNs)
+typedef struct {
+    int key;
+    int64_t time;
+} INPUT_EVENT;
+
+// Single-producer/single-consumer ring - the input thread only writes head, the game loop only writes tail
+// Both are free-running counters, kept on separate cache lines
+typedef struct {
+    _Alignas(64) _Atomic uint32_t head;
+    _Alignas(64) _Atomic uint32_t tail;
+    _Alignas(64) INPUT_EVENT events[INPUT_RING_SIZE];
+} INPUT_RING;
+
+// Input thread - blocks in poll() on the terminal and queues every byte read as a key, nothing is dropped between frames
+// Keys are single bytes: escape sequences are not decoded (the controls are plain characters)
+typedef struct {
+    INPUT_RING ring;
+    int fd;
+    int wake[2];            // pipe that stops the thread
+    int ready[2];           // pipe written after keys have been queued - the game loop may sleep in poll() on ready[0]
+    pthread_t thread;
+    _Atomic long dropped;   // keys lost to a full ring
+} INPUT_THREAD;
+
+// --- INPUT FUNCTIONS ---
+// Start reading fd (a terminal in cbreak mode) on a new thread - NULL if the thread cannot be started
+INPUT_THREAD* StartInputThread(int fd);
+void StopInputThread(INPUT_THREAD* input);
+// Oldest queued key, 0 if there is none - stays queued until PopInput
+int PeekInput(INPUT_THREAD* input, INPUT_EVENT* event);
+void PopInput(INPUT_THREAD* input);
+// Empty the ready pipe - before looking at the queue, so that a key queued afterwards wakes the next poll()
+void ClearInputReady(INPUT_THREAD* input);
+
+#endif // INPUT_H
@@ -0,0 +1,161 @@
+// lanes.c
+#include "lanes.h"
+
+
+// --- LANE INDEX FUNCTIONS ---
+// Sort the cars of a lane by x (insertion sort - the lane is almost always sorted already)
+void SortLane(LANE_INDEX* index, LANE* lane, CAR_POOL* cars)
+{
+    int* order = index->order + lane->start;
+    for (int i = 1; i < lane->count; i++)
+    {
+        int car = order[i];
+        int j = i - 1;
+        while (j >= 0 && cars->x[order[j]] > cars->x[car])
+        {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = car;
+    }
+}
+
+// Lane index initializer - counting sort of the cars by row
+LANE_INDEX* InitLaneIndex(CAR_POOL* cars, ARENA* arena)
+{
+    LANE_INDEX* index = (LANE_INDEX*)ArenaAlloc(arena, sizeof(LANE_INDEX));
+    index->nRows = 1;
+    for (int i = 0; i < cars->count; i++)
+    {
+        if (cars->y[i] + 1 > index->nRows)
+        {
+            index->nRows = cars->y[i] + 1;
+        }
+    }
+
+    int* rowCount = (int*)ArenaCalloc(arena, index->nRows, sizeof(int));
+    for (int i = 0; i < cars->count; i++)
+    {
+        rowCount[cars->y[i]]++;
+    }
+
+    index->rowLane = (int*)ArenaAlloc(arena, index->nRows * sizeof(int));
+    index->lanes = (LANE*)ArenaAlloc(arena, index->nRows * sizeof(LANE));
+    index->nLanes = 0;
+    int start = 0;
+    for (int row = 0; row < index->nRows; row++)
+    {
+        index->rowLane[row] = -1;
+        if (rowCount[row] > 0)
+        {
+            LANE* lane = &index->lanes[index->nLanes];
+            lane->y = row;
+            lane->start = start;
+            lane->count = 0;
+            index->rowLane[row] = index->nLanes++;
+            start += rowCount[row];
+        }
+    }
+
+    index->order = (int*)ArenaAlloc(arena, (cars->count > 0 ? cars->count : 1) * sizeof(int));
+    for (int i = 0; i < cars->count; i++)
+    {
+        LANE* lane = &index->lanes[index->rowLane[cars->y[i]]];
+        index->order[lane->start + lane->count++] = i;
+    }
+    index->crowded = (int*)ArenaAlloc(arena, index->nRows * sizeof(int));
+    index->nCrowded = 0;
+    for (int i = 0; i < index->nLanes; i++)
+    {
+        if (index->lanes[i].count > 1)
+        {
+            index->crowded[index->nCrowded++] = i;
+        }
+    }
+    UpdateLaneIndex(index, cars);
+    return index;
+}
+
+void UpdateLaneIndex(LANE_INDEX* index, CAR_POOL* cars)
+{
+    for (int i = 0; i < index->nCrowded; i++)
+    {
+        SortLane(index, &index->lanes[index->crowded[i]], cars);
+    }
+}
+
+size_t LaneIndexSize(int count, int rows)
+{
+    return sizeof(LANE_INDEX) + rows * (3 * sizeof(int) + sizeof(LANE)) + (count + 1) * sizeof(int) + 6 * ARENA_ALIGN;
+}
+
+
+// --- QUERIES ---
+// First car of the lane whose x is greater than x (binary search)
+int FirstCarAfter(LANE_INDEX* index, LANE* lane, CAR_POOL* cars, int x)
+{
+    int* order = index->order + lane->start;
+    int low = 0;
+    int high = lane->count;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (cars->x[order[middle]] > x)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+// Visit the cars overlapping the given box, stops early when max cars have been found
+// With a sprite (at the top-left corner of the box) only the cars whose opaque cells overlap its own are taken
+int FindCars(LANE_INDEX* index, CAR_POOL* cars, int x, int y, int width, int height, SPRITE_ATLAS* atlas, SPRITE* sprite, int* found, int max)
+{
+    int n = 0;
+    int first = y - cars->height + 1 > 0 ? y - cars->height + 1 : 0;    // lanes whose cars can reach the box
+    int last = y + height - 1 < index->nRows - 1 ? y + height - 1 : index->nRows - 1;
+    for (int row = first; row <= last && n < max; row++)
+    {
+        if (index->rowLane[row] < 0)
+        {
+            continue;
+        }
+        LANE* lane = &index->lanes[index->rowLane[row]];
+        int* order = index->order + lane->start;
+        for (int i = FirstCarAfter(index, lane, cars, x - cars->width); i < lane->count && n < max; i++)
+        {
+            if (cars->x[order[i]] >= x + width)
+            {
+                break;  // sorted by x - the rest of the lane is further right
+            }
+            int car = order[i];
+            if (!sprite || SpritesOverlap(sprite, x, y, GetSprite(atlas, cars->sprite[car]), cars->x[car], cars->y[car]))
+            {
+                found[n++] = car;
+            }
+        }
+    }
+    return n;
+}
+
+int CollideLanes(LANE_INDEX* index, CAR_POOL* cars, int x, int y, int width, int height)
+{
+    int car;
+    return FindCars(index, cars, x, y, width, height, NULL, NULL, &car, 1) > 0 ? car : -1;
+}
+
+int CollideSprites(LANE_INDEX* index, CAR_POOL* cars, SPRITE_ATLAS* atlas, SPRITE* sprite, int x, int y)
+{
+    int car;
+    return FindCars(index, cars, x, y, sprite->width, sprite->height, atlas, sprite, &car, 1) > 0 ? car : -1;
+}
+
+int NearbyCars(LANE_INDEX* index, CAR_POOL* cars, int x, int y, int width, int height, int distance, int* found, int max)
+{
+    return FindCars(index, cars, x - distance, y - distance, width + 2 * distance, height + 2 * distance, NULL, NULL, found, max);
+}
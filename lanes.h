@@ -0,0 +1,40 @@
+// lanes.h
+#ifndef LANES_H
+#define LANES_H
+
+#include "cars.h"
+#include "sprite.h"
+
+// Lane - cars sharing the same top row, cars never leave their row
+typedef struct {
+    int y;
+    int start;      // first entry in LANE_INDEX::order
+    int count;
+} LANE;
+
+// Lane index - cars bucketed by row and sorted by x inside each lane
+typedef struct {
+    LANE* lanes;
+    int nLanes;
+    int* rowLane;   // row -> lane, -1 for rows without cars
+    int nRows;
+    int* order;     // car indices, lane by lane
+    int* crowded;   // lanes with more than one car - the only ones that can get out of order
+    int nCrowded;
+} LANE_INDEX;
+
+// --- LANE INDEX FUNCTIONS ---
+LANE_INDEX* InitLaneIndex(CAR_POOL* cars, ARENA* arena);
+// Restore the x order after the cars have moved - cheap, as the order hardly ever changes
+void UpdateLaneIndex(LANE_INDEX* index, CAR_POOL* cars);
+// Arena memory needed by the index of count cars spread over rows
+size_t LaneIndexSize(int count, int rows);
+
+// Index of a car overlapping the given box, -1 if none - only the lanes the box spans are checked
+int CollideLanes(LANE_INDEX* index, CAR_POOL* cars, int x, int y, int width, int height);
+// Index of a car whose opaque cells overlap those of the sprite at (x, y), -1 if none - the collision of the game
+int CollideSprites(LANE_INDEX* index, CAR_POOL* cars, SPRITE_ATLAS* atlas, SPRITE* sprite, int x, int y);
+// Cars closer than distance (in both axes) to the given box, up to max of them are written to found
+int NearbyCars(LANE_INDEX* index, CAR_POOL* cars, int x, int y, int width, int height, int distance, int* found, int max);
+
+#endif // LANES_H
@@ -9,91 +9,73 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <poll.h>
 #include <unistd.h>
+#include <sys/resource.h>
 #include <ncurses.h>
 #include "cfg.h"
+#include "sim.h"
+#include "render.h"
+#include "headless.h"
+#include "replay.h"
+#include "batch.h"
+#include "pacer.h"
+#include "profile.h"
+#include "bench.h"
+#include "input.h"
+#include "server.h"
+#include "client.h"
+#include "solver.h"
+#include "watch.h"
+#include "rewind.h"
 
 
 // --- CONSTANTS ---
-// Main loop (Play function) constants indicating the reason to end the game
-typedef enum {
-    SUCCESS,        // reached destination
-    FAILURE,        // died
-    TIME_OVER,      // time is over
-    INTERRUPTED     // decision to quit
-} GameResult;
-
 // Delay constants for real-time
 const int DELAY_ON = 1;
 const int DELAY_OFF = 0;
+// Longest idle sleep in ms - a reloaded config is taken within it
+const int IDLE_MAX_WAIT = 1000;
 
 
 // --- DATA STRUCTURES ---
-typedef enum {
-    COLOR_MAIN,
-    COLOR_STATUS,
-    COLOR_PLAYABLE,
-    COLOR_FROG,
-    COLOR_CAR,
-    COLOR_DEST
-} Color;
-
-// Window structure
-typedef struct {
-    WINDOW* window; // extends ncurses window
-    Color color;
-    int x, y;       // top-left corner coordinates
-    int rows, cols;
-} WIN;
-
-// Game object structure - used for frog directly, extended by CAR
+// Command line options
 typedef struct {
-    WIN* win;
-    Color color;
-    int moveFactor;
-    int x, y;           // top-left corner coordinates
-    int xmin, xmax;     // movement boundaries
-    int ymin, ymax;
-    int width, height;
-    char** shape;
-} OBJ;
-
-typedef enum {
-    Enemy,      // normal car
-    Neutral,    // stops when the frog is close
-    Friendly    // helps the frog on demand
-} CarType;
-
-// Car structure
+    uint64_t seed;          // seed of the game (of the first game for --headless)
+    int headless;           // number of headless games, 0 for the terminal game
+    const char* record;     // file to record the terminal game to
+    const char* replay;     // recording to verify
+    const char* view;       // recording to watch
+    const char* batch;      // sweep file of the batch mode
+    int threads;            // worker threads of the batch mode, 0 for one per core
+    int fps;                // rendered frames per second, 0 for every simulation step
+    const char* profile;    // file to write the frame profile of the terminal game to
+    int bench;              // 1 for the benchmark mode
+    const char* benchPreset;    // scale to benchmark, NULL for all
+    int ansi;               // 1 to draw the terminal game with the ANSI back end instead of ncurses
+    int endless;            // 1 to play on the endless road, whatever the config says
+    const char* server;     // Unix socket to serve the shared game on
+    const char* connect;    // Unix socket of the server to play on
+    int spectate;           // 1 to watch the server's game without a frog
+    int solve;              // number of games to check for solvability
+    int autopilot;          // 1 to let the solver play the terminal game
+    int watch;              // 1 to reload the settings file of the terminal game whenever it changes
+    int rewind;             // seconds of play kept for rewinding the terminal game, 0 for none
+    int idle;               // 1 to sleep until the screen of the terminal game changes instead of waking every step
+} OPTIONS;
+
+// Terminal game - what a reloaded config of another world is rebuilt from
 typedef struct {
-    OBJ* obj;           // extends OBJ
-    int direction;      // 0 for left, 1 for right
-    int dynamicSpeed;   // 0 for constant speed, 1 for dynamic
-    int disappearing;   // 0 for perpetually bouncing car, 1 for disappearing (replaced with a new car)
-    CarType type;
-} CAR;
-
-// Destination structure
-typedef struct {
-    WIN* win;
-    Color color;
-    int x, y;           // top-left corner coordinates
-    int width, height;
-} DEST;
-
-// Timer structure
-typedef struct {
-    int frameTime;
-    float timeLeft;
-    int frameNo;
-} TIMER;
-
-
-// --- RANDOM NUMBER (inclusive) ---
-int RandInt(int min, int max)
-{
-    return min + rand() % (max - min + 1);
-}
+    OPTIONS* options;
+    CFG* cfg;
+    SPRITE_ATLAS* sprites;
+    ARENA* arena;
+    SIM* sim;
+    RENDERER* renderer;
+    SOLVER* autopilot;      // NULL unless the solver plays
+    REWIND* rewind;         // NULL unless the game can be rewound
+} GAME;
 
 
 // --- WINDOW FUNCTIONS ---
@@ -107,13 +89,7 @@ WINDOW* InitGame()
         exit(EXIT_FAILURE);
     }
 
-    start_color();  // initialize colors
-    init_pair(COLOR_MAIN, COLOR_WHITE, COLOR_BLACK);
-    init_pair(COLOR_PLAYABLE, COLOR_BLACK, COLOR_WHITE);
-    init_pair(COLOR_STATUS, COLOR_BLACK, COLOR_WHITE);
-    init_pair(COLOR_FROG, COLOR_GREEN, COLOR_WHITE);
-    init_pair(COLOR_CAR, COLOR_RED, COLOR_WHITE);
-    init_pair(COLOR_DEST, COLOR_GREEN, COLOR_BLUE);
+    InitColors();   // initialize colors
 
     noecho();       // turn off displaying input and hide cursor
     curs_set(0);
@@ -131,20 +107,6 @@ void Welcome(WINDOW* win)
 
 
 // --- WIN FUNCTIONS ---
-// Cleaning the window (prints " ")
-void CleanWin(WIN* win)
-{
-    wattron(win->window, COLOR_PAIR(win->color));
-    for (int row = 0; row < win->rows; row++)
-    {
-        for (int col = 0; col < win->cols; col++)
-        {
-            mvwprintw(win->window, row, col, " ");
-        }
-    }
-    box(win->window, 0, 0); // add border to outermost rows/cols
-}
-
 // Window initializer
 WIN* InitWin(WINDOW* mainWindow, int rows, int cols, int y, int x, Color color, int delay)
 {
@@ -155,6 +117,7 @@ WIN* InitWin(WINDOW* mainWindow, int rows, int cols, int y, int x, Color color,
     win->cols = cols;
     win->color = color;
     win->window = subwin(mainWindow, rows, cols, y, x); // create the window inside of the main window
+    win->ansi = NULL;
     CleanWin(win);
     if (delay == DELAY_OFF)
     {
@@ -164,388 +127,878 @@ WIN* InitWin(WINDOW* mainWindow, int rows, int cols, int y, int x, Color color,
     return win;
 }
 
-
-// --- STATUS FUNCTIONS ---
-void PrintTime(WIN* win, float timeLeft)
+// Height of the playable window - the whole world when it fits in the terminal, a camera following the frog otherwise
+int ViewRows(CFG* cfg)
 {
-    mvwprintw(win->window, 1, 2, "Time: %.2f", timeLeft);
-    wrefresh(win->window);
+    int rows = LINES - cfg->area->offy - cfg->area->statusRows;
+    int minimum = cfg->frog->height + 2;    // the frog and the border
+    rows = rows < minimum ? minimum : rows;
+    return cfg->area->playableRows < rows ? cfg->area->playableRows : rows;
 }
 
-void PrintPosition(WIN* win, OBJ* frog)
-{
-    mvwprintw(win->window, 1, win->cols / 2 - 10, "Position: x: %d y: %d", frog->x, frog->y);
-    wrefresh(win->window);
-}
 
+// --- STATUS FUNCTIONS ---
 // Status window initializer
-void InitStatus(WIN* win, TIMER* timer, OBJ* frog)
+void InitStatus(WIN* win)
 {
-    box(win->window, 0, 0);
-    PrintTime(win, timer->timeLeft);
-    PrintPosition(win, frog);
+    DrawBox(win);
     char* signature = "Kacper Neumann, 203394";
-    mvwprintw(win->window, 1, win->cols - strlen(signature) - 2, "%s", signature);
+    PrintWin(win, 1, win->cols - strlen(signature) - 2, "%s", signature);
 }
 
-// Display information about the result of the game and count down to quit
-void EndGame(WIN* win, GameResult result, int quitTime)
+// Message about the result of the game, NULL while it is running
+const char* ResultMessage(GameResult result)
 {
-    CleanWin(win);
-    char message[100];
     switch (result)
     {
         case SUCCESS:
-            sprintf(message, "Congratulations! You have reached the destination.");
-            break;
+            return "Congratulations! You have reached the destination.";
         case FAILURE:
-            sprintf(message, "You died. Game over.");
-            break;
+            return "You died. Game over.";
         case TIME_OVER:
-            sprintf(message, "Time is over. Game over.");
-            break;
+            return "Time is over. Game over.";
         case INTERRUPTED:
-            sprintf(message, "You have decided to quit the game.");
+            return "You have decided to quit the game.";
+        default:
+            return NULL;    // game has not ended
+    }
+}
+
+// Display information about the result of the game and count down to quit
+void EndGame(WIN* win, GameResult result, int quitTime)
+{
+    CleanWin(win);
+    const char* message = ResultMessage(result);
+    if (!message)
+    {
+        return;
     }
     for (int seconds = quitTime; seconds > 0; seconds--)
     {
-        mvwprintw(win->window, 1, 2, "%s Closing the game in %d seconds...", message, seconds);
-        wrefresh(win->window);
+        PrintWin(win, 1, 2, "%s Closing the game in %d seconds...", message, seconds);
+        RefreshWin(win);
         sleep(1);
     }
 }
 
+// Profiler overlay - p99 of the phases and the frame budget on the bottom border of the status window
+void PrintProfileOverlay(WIN* win, PROFILER* profiler)
+{
+    HISTOGRAM* phases = profiler->phases;
+    char text[256];
+    snprintf(text, sizeof(text), " p99 us: in %lld frog %lld cars %lld coll %lld draw %lld | frame p50 %lld p99 %lld max %lld | over %ld | lag p99 %lld ",
+        (long long)HistogramPercentile(&phases[PHASE_INPUT], 0.99) / 1000, (long long)HistogramPercentile(&phases[PHASE_FROG], 0.99) / 1000,
+        (long long)HistogramPercentile(&phases[PHASE_CARS], 0.99) / 1000, (long long)HistogramPercentile(&phases[PHASE_COLLISION], 0.99) / 1000,
+        (long long)HistogramPercentile(&phases[PHASE_RENDER], 0.99) / 1000, (long long)HistogramPercentile(&phases[PHASE_FRAME], 0.50) / 1000,
+        (long long)HistogramPercentile(&phases[PHASE_FRAME], 0.99) / 1000, (long long)phases[PHASE_FRAME].max / 1000,
+        phases[PHASE_FRAME].overruns, (long long)HistogramPercentile(&profiler->latency, 0.99) / 1000);
+    DrawText(win, win->rows - 1, 2, text, win->cols - 4, win->color);
+}
 
-// --- OBJ FUNCTIONS ---
-// Print game object's shape
-void PrintObj(OBJ* obj)
+
+// --- MAIN LOOP ---
+// Toggle the profiler overlay
+void ToggleProfileOverlay(WIN* statusWin, PROFILER* profiler)
 {
-    wattron(obj->win->window, COLOR_PAIR(obj->color));
-    for (int i = 0; i < obj->height; i++)
+    profiler->visible = !profiler->visible;
+    if (!profiler->visible)
     {
-        mvwprintw(obj->win->window, obj->y + i, obj->x, "%s", obj->shape[i]);
+        DrawBox(statusWin);
     }
-    wattron(obj->win->window, COLOR_PAIR(obj->win->color));
-    wrefresh(obj->win->window);
 }
 
-// Move the game object along both axes by 1
-void MoveObj(OBJ* obj, int dx, int dy)
+// Message on the bottom border of the status window - until the profiler overlay takes it
+void PrintStatusMessage(WIN* statusWin, const char* message)
 {
-    wattron(obj->win->window, COLOR_PAIR(obj->color));
+    char text[WATCH_MESSAGE_SIZE + 4];
+    snprintf(text, sizeof(text), " %s ", message);
+    DrawBox(statusWin);
+    DrawText(statusWin, statusWin->rows - 1, 2, text, statusWin->cols - 4, statusWin->color);
+}
 
-    char* emptyRow = (char*)malloc(obj->width * sizeof(char));    // string of empty spaces to erase the old position row
-    memset(emptyRow, ' ', obj->width);
+// Frames of the rewind history
+int RewindFrames(OPTIONS* options, CFG* cfg)
+{
+    return (int)((int64_t)options->rewind * 1000 / cfg->timing->frameTime);
+}
 
-    if ((dy == 1) && (obj->y + obj->height < obj->ymax))
+// Rebuild the game for a config of another world - same seed and windows, the game starts again
+void RebuildGame(GAME* game, CFG* cfg)
+{
+    uint64_t seed = game->sim->seed;
+    PROFILER* profiler = game->sim->profiler;
+    WIN* playableWin = game->renderer->playable;
+    WIN* statusWin = game->renderer->status;
+    RENDER_STATS stats = game->renderer->stats;
+    FreeRenderer(game->renderer);
+    if (game->autopilot)
     {
-        obj->y += dy;
-        mvwprintw(obj->win->window, obj->y - 1, obj->x, "%s", emptyRow);
+        FreeSolver(game->autopilot);
     }
-    else if ((dy == -1) && (obj->y > obj->ymin))
+    FreeArena(game->arena);
+    FreeSpriteAtlas(game->sprites);
+    FreeCfg(game->cfg);
+
+    game->cfg = cfg;
+    game->sprites = InitSpriteAtlas(cfg);
+    game->arena = InitArena(SimArenaSize(cfg));
+    game->sim = InitSim(cfg, game->sprites, seed, game->arena);
+    game->sim->profiler = profiler;
+    game->renderer = InitRenderer(playableWin, statusWin, game->sim);
+    game->renderer->stats = stats;
+    game->renderer->timeDecimals = game->options->idle ? 0 : game->renderer->timeDecimals;
+    game->autopilot = game->options->autopilot && !cfg->area->endless ? InitSolver(game->sim) : NULL;
+    if (game->rewind)
     {
-        obj->y += dy;
-        mvwprintw(obj->win->window, obj->y + obj->height, obj->x, "%s", emptyRow);
+        FreeRewind(game->rewind);
+        game->rewind = InitRewind(game->sim, RewindFrames(game->options, cfg));
     }
+}
 
-    if ((dx == 1) && (obj->x + obj->width < obj->xmax))
+// Switch the game to a reloaded config at a frame boundary - in place if the world is the same, otherwise it starts again
+// The windows stay: a world that does not fit them is turned down
+void ReloadGame(GAME* game, CFG_RELOAD* reload, PACER* pacer)
+{
+    CFG* cfg = reload->cfg;
+    const char* message = reload->message;
+    if (cfg)
     {
-        obj->x += dx;
-        for (int i = 0; i < obj->height; i++)
+        AREA_CFG* area = game->cfg->area;
+        cfg->area->statusRows = area->statusRows;
+        cfg->area->offy = area->offy;
+        cfg->area->offx = area->offx;
+        cfg->area->endless |= game->options->endless;
+        int rows = game->renderer->playable->rows;
+        if (cfg->area->cols != area->cols || cfg->area->playableRows < rows || cfg->frog->height + 2 > rows)
         {
-            mvwprintw(obj->win->window, obj->y + i, obj->x - 1, " ");
+            message = "The new playable area does not fit the window - restart the game to apply it.";
+            FreeCfg(cfg);
         }
-    }
-    else if ((dx == -1) && (obj->x > obj->xmin))
-    {
-        obj->x += dx;
-        for (int i = 0; i < obj->height; i++)
+        else if (SameWorld(cfg, game->cfg))
+        {
+            ApplyCfg(game->sim, cfg);
+            FreeCfg(game->cfg);
+            game->cfg = cfg;
+            if (game->rewind)
+            {
+                ResetRewind(game->rewind, game->sim);   // the history was recorded at the old speeds
+            }
+            if (game->autopilot)
+            {
+                FreeSolver(game->autopilot);    // its cached car positions and frog cooldown are those of the old speeds
+                game->autopilot = InitSolver(game->sim);
+            }
+        }
+        else
         {
-            mvwprintw(obj->win->window, obj->y + i, obj->x + obj->width, " ");
+            RebuildGame(game, cfg);
+        }
+        SetPacerStep(pacer, game->cfg->timing->frameTime);
+        if (game->sim->profiler)
+        {
+            SetProfilerBudget(game->sim->profiler, game->cfg->timing->frameTime);
         }
     }
-
-    PrintObj(obj);
+    PrintStatusMessage(game->renderer->status, message);
+    free(reload);
 }
 
-int Collision(OBJ* obj, OBJ* other)
+// Idle pacing - sleep until the screen changes by itself or a key comes in. The game steps one at a time while a key
+// is queued, the game is rewound or the profiler overlay is shown, and the autopilot's frog wakes it when it may move
+void WaitIdle(GAME* game, PACER* pacer, INPUT_THREAD* input, int64_t rewindUntil)
 {
-    return ((
-        (obj->y >= other->y && obj->y < other->y + other->height) ||
-        (other->y >= obj->y && other->y < obj->y + obj->height)
-        ) && (
-            (obj->x >= other->x && obj->x < other->x + other->width) ||
-            (other->x >= obj->x && other->x < obj->x + obj->width)
-            )) ? 1 : 0;
-}
-
-void SetObjPosition(OBJ* obj, int x, int y)
-{
-    obj->x = x;
-    obj->y = y;
-}
-
-void AllocateShape(OBJ* obj, char** shape, int height, int width)
-{
-    obj->shape = (char**)malloc(height * sizeof(char*));
-    for (int i = 0; i < height; i++)
+    SIM* sim = game->sim;
+    INPUT_EVENT event;
+    ClearInputReady(input);
+    int steps = 1;
+    if (!PeekInput(input, &event) && pacer->nextStep >= rewindUntil && !sim->profiler->visible)
     {
-        obj->shape[i] = (char*)malloc((width + 1) * sizeof(char));   // +1 for '\0'
-        strcpy(obj->shape[i], shape[i]);
+        int maxSteps = IDLE_MAX_WAIT / sim->cfg->timing->frameTime;
+        steps = StepsToChange(game->renderer, sim, maxSteps > 1 ? maxSteps : 1);
+        int frogReady = sim->frog->moveFactor + sim->cfg->frog->moveFactor - sim->timer->frameNo + 1;
+        if (game->autopilot && frogReady < steps)
+        {
+            steps = frogReady > 1 ? frogReady : 1;
+        }
     }
+    WaitPacerIdle(pacer, steps, input->ready[0]);
 }
 
-// Frog initializer
-OBJ* InitFrog(WIN* win, Color color, FROG_CFG* cfg)
-{
-    OBJ* frog = (OBJ*)malloc(sizeof(OBJ));
-    frog->win = win;
-    frog->color = color;
-    frog->width = cfg->width;
-    frog->height = cfg->height;
-    frog->moveFactor = 0;
-    frog->xmin = 1;
-    frog->xmax = win->cols - 1;
-    frog->ymin = 1;
-    frog->ymax = win->rows - 1;
-
-    AllocateShape(frog, cfg->shape, cfg->height, cfg->width);
-    SetObjPosition(frog, (win->cols - frog->width) / 2, win->rows - frog->height - 1);
-    return frog;
-}
-
-// Frog movement
-void MoveFrog(OBJ* frog, CONTROLS_CFG* cfg, char key, int moveFactor, int frame)
+// Terminal front end of the simulation - waits for the next step, steps the game with the queued keys and draws it
+// Every step takes the oldest key read before its end (one key per step, a key the frog cannot take now is dropped),
+// steps missed while overrunning are caught up (up to PACER_MAX_CATCH_UP)
+// PROFILE_KEY shows and hides the profiler overlay, the game does not see it
+// With an autopilot the solver picks the keys, the player can only quit
+// With a watcher a reloaded config is taken before the steps of a frame
+// With idle pacing the loop sleeps through the steps that change nothing on the screen and runs them together
+// With a rewind history REWIND_KEY steps the game back instead of forward for REWIND_HOLD_MS (held down, as long as it repeats)
+GameResult Play(GAME* game, WIN* statusWin, RECORDING* recording, PACER* pacer, INPUT_THREAD* input, CFG_WATCHER* watcher)
 {
-    if (frame - frog->moveFactor >= moveFactor)   // movement cooldown condition
+    PROFILER* profiler = game->sim->profiler;
+    int64_t unshown[PACER_MAX_CATCH_UP];    // read times of the keys taken since the last rendered frame
+    int nUnshown = 0;
+    int64_t rewindUntil = 0;
+    GameResult result = RUNNING;
+    while (result == RUNNING)
     {
-        if (key == cfg->up)
+        StartProfileFrame(profiler);
+        if (game->options->idle)
         {
-            MoveObj(frog, 0, -1);
+            WaitIdle(game, pacer, input, rewindUntil);
         }
-        else if (key == cfg->down)
+        else
         {
-            MoveObj(frog, 0, 1);
+            WaitPacer(pacer);
         }
-        else if (key == cfg->left)
+        int steps = DueSteps(pacer);
+        EndPhase(profiler, PHASE_SLEEP);
+        CFG_RELOAD* reload = watcher ? TakeCfgReload(watcher) : NULL;
+        if (reload)
         {
-            MoveObj(frog, -1, 0);
+            ReloadGame(game, reload, pacer);
         }
-        else if (key == cfg->right)
+        SIM* sim = game->sim;
+        for (int i = 0; i < steps && result == RUNNING; i++)
         {
-            MoveObj(frog, 1, 0);
+            int64_t stepEnd = pacer->nextStep - (int64_t)(steps - 1 - i) * pacer->step;
+            INPUT_EVENT event;
+            int key = NO_KEY;
+            while (key == NO_KEY && PeekInput(input, &event) && event.time < stepEnd)
+            {
+                PopInput(input);
+                if (event.key == PROFILE_KEY)
+                {
+                    ToggleProfileOverlay(statusWin, profiler);
+                    continue;
+                }
+                if (event.key == REWIND_KEY && game->rewind)
+                {
+                    rewindUntil = event.time + REWIND_HOLD_MS * 1000000LL;
+                    continue;
+                }
+                key = event.key;
+            }
+            if (game->autopilot && key != sim->cfg->controls->quit)
+            {
+                key = AutopilotKey(game->autopilot);
+            }
+            EndPhase(profiler, PHASE_INPUT);
+            if (game->rewind && stepEnd < rewindUntil && key != sim->cfg->controls->quit)
+            {
+                StepBack(game->rewind, sim);    // the keys read meanwhile are dropped
+                continue;
+            }
+            result = recording ? StepRecorded(sim, recording, key) : StepSim(sim, key);
+            if (game->rewind)
+            {
+                PushRewind(game->rewind, sim);
+            }
+            if (sim->input != NO_KEY && !game->autopilot && nUnshown < PACER_MAX_CATCH_UP)
+            {
+                unshown[nUnshown++] = event.time;
+            }
+        }
+        if (steps > 0 && (RenderDue(pacer) || result != RUNNING))
+        {
+            if (profiler->visible)
+            {
+                PrintProfileOverlay(statusWin, profiler);
+            }
+            RenderFrame(game->renderer, sim);
+            for (int i = 0; i < nUnshown; i++)
+            {
+                ProfileLatency(profiler, unshown[i]);
+            }
+            nUnshown = 0;
+            EndPhase(profiler, PHASE_RENDER);
         }
-        frog->moveFactor = frame;
+        EndProfileFrame(profiler);
     }
+    return result;
 }
 
 
-// --- CAR FUNCTIONS ---
-// Car initializer
-CAR* InitCar(WIN* win, Color color, CARS_CFG* cfg, int y, int dynamicSpeed, CarType type)
+// --- CLEANUP ---
+void Cleanup(WIN* playableWin, WIN* statusWin, WINDOW* mainWindow, ARENA* arena)
 {
-    OBJ* obj = (OBJ*)malloc(sizeof(OBJ));
-    obj->win = win;
-    obj->color = color;
-    obj->width = cfg->width;
-    obj->height = cfg->height;
-    obj->moveFactor = cfg->moveFactor;
-    obj->xmin = 1;
-    obj->xmax = win->cols - 1;
-    obj->ymin = obj->y; // cars don't move vertically
-    obj->ymax = obj->y;
-
-    AllocateShape(obj, cfg->shape, cfg->height, cfg->width);
-
-    CAR* car = (CAR*)malloc(sizeof(CAR));
-    car->obj = obj;
-    car->direction = RandInt(0, 1);     // initial direction is random
-    car->dynamicSpeed = dynamicSpeed;
-    car->disappearing = RandInt(0, 1);  // may disappear
-    car->type = type;
-    SetObjPosition(obj, car->direction == 0 ? obj->xmax - obj->width : obj->xmin, y); // depends on initial direction
-    return car;
+    delwin(playableWin->window);
+    free(playableWin);
+    delwin(statusWin->window);
+    free(statusWin);
+    delwin(mainWindow);
+    FreeArena(arena);   // the whole game at once
+    endwin();
+    refresh();
 }
 
-CAR** GenerateCars(WIN* win, Color color, CARS_CFG* cfg, int frogHeight)
+
+// --- MAIN PROGRAM ---
+// Terminal game
+int RunGame(CFG* cfg, OPTIONS* options)
 {
-    CAR** cars = (CAR**)malloc(cfg->nCars * sizeof(CAR*));
-    for (int i = 0; i < cfg->nCars; i++)
+    WINDOW* mainWindow = InitGame();
+    Welcome(mainWindow);
+
+    int viewRows = ViewRows(cfg);
+    WIN* playableWin = InitWin(mainWindow, viewRows, cfg->area->cols, cfg->area->offy, cfg->area->offx, COLOR_PLAYABLE, DELAY_ON);
+    WIN* statusWin = InitWin(mainWindow, cfg->area->statusRows, cfg->area->cols, viewRows + cfg->area->offy, cfg->area->offx, COLOR_STATUS, DELAY_OFF);
+    GAME game;
+    game.options = options;
+    game.cfg = cfg;
+    game.sprites = InitSpriteAtlas(cfg);
+    game.arena = InitArena(SimArenaSize(cfg));
+    game.sim = InitSim(cfg, game.sprites, options->seed, game.arena);
+    RECORDING* recording = options->record ? InitRecording(game.sim) : NULL;
+
+    ANSI_TERM* ansi = NULL;
+    if (options->ansi)
     {
-        cars[i] = InitCar(win, color, cfg, i * (cfg->height + frogHeight) + frogHeight, 0, Enemy);
-        MoveObj(cars[i]->obj, 0, 0); // force first render
+        ansi = InitAnsiTerm(STDOUT_FILENO, LINES, COLS);  // ncurses only reads the keys from here on
+        InitAnsiColors(ansi);
+        playableWin->ansi = ansi;
+        statusWin->ansi = ansi;
+        CleanWin(playableWin);
+        CleanWin(statusWin);
     }
-    return cars;
-}
+    InitStatus(statusWin);
+    game.renderer = InitRenderer(playableWin, statusWin, game.sim);
+    game.renderer->timeDecimals = options->idle ? 0 : game.renderer->timeDecimals;  // whole seconds, a kiosk need not wake for the rest
+
+    PACER pacer;
+    InitPacer(&pacer, cfg->timing->frameTime, options->fps);
+    PROFILER profiler;
+    InitProfiler(&profiler, cfg->timing->frameTime);
+    game.sim->profiler = &profiler;
+    cbreak();       // keys are read as they are typed,
+    typeahead(-1);  // by the input thread only
+    INPUT_THREAD* input = StartInputThread(STDIN_FILENO);
+    if (!input)
+    {
+        endwin();
+        fprintf(stderr, "Error starting the input thread.\n");
+        return EXIT_FAILURE;
+    }
+    CFG_WATCHER* watcher = options->watch ? StartCfgWatcher(CFG_FILE) : NULL;
+    if (options->watch && !watcher)
+    {
+        PrintStatusMessage(statusWin, "Cannot watch " CFG_FILE " - it will not be reloaded.");
+    }
+    game.autopilot = options->autopilot ? InitSolver(game.sim) : NULL;
+    game.rewind = options->rewind > 0 ? InitRewind(game.sim, RewindFrames(options, cfg)) : NULL;
+    GameResult result = Play(&game, statusWin, recording, &pacer, input, watcher);
+    long lostKeys = atomic_load(&input->dropped);
+    StopInputThread(input);
+    long reloads = 0;
+    if (watcher)
+    {
+        reloads = atomic_load(&watcher->reloads);
+        StopCfgWatcher(watcher);
+    }
+    if (game.autopilot)
+    {
+        FreeSolver(game.autopilot);
+    }
+    cfg = game.cfg;     // the one reloaded last
+    EndGame(statusWin, result, cfg->timing->quitTime);
+    if (recording)
+    {
+        FinishRecording(recording, game.sim);
+    }
+    int distance = SimDistance(game.sim);
+    int checkpoints = game.sim->checkpoints;
+    Cleanup(playableWin, statusWin, mainWindow, game.arena);
+    PrintRenderStats(game.renderer, stdout);
+    if (ansi)
+    {
+        FreeAnsiTerm(ansi);
+    }
+    PrintPacerStats(&pacer, stdout);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stdout, "cpu time: %.3f s\n", usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+    fprintf(stdout, "keys lost: %ld\n", lostKeys);
+    if (options->watch)
+    {
+        fprintf(stdout, "config reloads: %ld\n", reloads);
+    }
+    if (game.rewind)
+    {
+        PrintRewindStats(game.rewind, stdout);
+        FreeRewind(game.rewind);
+    }
+    if (cfg->area->endless)
+    {
+        fprintf(stdout, "distance: %d rows, %d checkpoints\n", distance, checkpoints);
+    }
+    FreeRenderer(game.renderer);
+    FreeSpriteAtlas(game.sprites);
 
-// Reverse direction when car hits the wall (bouncing)
-void ReverseCarDirection(CAR* car)
-{
-    if (car->direction == 1 && car->obj->x == car->obj->xmax - car->obj->width)
+    if (options->profile)
     {
-        car->direction = 0;
+        FILE* file = fopen(options->profile, "w");
+        if (!file)
+        {
+            fprintf(stderr, "Error writing the profile to %s.\n", options->profile);
+            return EXIT_FAILURE;
+        }
+        PrintProfileCsv(&profiler, file);
+        fclose(file);
     }
-    else if (car->direction == 0 && car->obj->x == car->obj->xmin)
+
+    if (recording)
     {
-        car->direction = 1;
+        int saved = SaveRecording(recording, options->record);
+        FreeRecording(recording);
+        if (saved != 0)
+        {
+            fprintf(stderr, "Error saving the recording to %s.\n", options->record);
+            return EXIT_FAILURE;
+        }
     }
+    return EXIT_SUCCESS;
 }
 
-// Car movement
-void MoveCar(CAR* car, int frame)
+// Headless games - prints statistics instead of drawing
+int RunHeadlessMode(CFG* cfg, OPTIONS* options)
 {
-    ReverseCarDirection(car);
-    if (frame % car->obj->moveFactor == 0)
-    {
-        MoveObj(car->obj, car->direction == 0 ? -1 : 1, 0);  // depends on direction
-    }
+    HEADLESS_STATS stats;
+    RunHeadless(cfg, options->headless, options->seed, &stats);
+    PrintHeadlessStats(&stats, stdout);
+    return EXIT_SUCCESS;
+}
 
-    mvwhline(car->obj->win->window, car->obj->y + car->obj->height, car->obj->win->x + 1, '-', car->obj->win->cols - 2); // draw lane
+// Solvability check of the config - the fastest path of every game from its start, statistics on stdout
+int RunSolveMode(CFG* cfg, OPTIONS* options)
+{
+    SOLVE_STATS stats;
+    RunSolveCheck(cfg, options->solve, options->seed, &stats);
+    PrintSolveStats(&stats, stdout);
+    return EXIT_SUCCESS;
 }
 
+// Microbenchmarks of the simulation and the renderer - JSON on stdout, progress on stderr
+int RunBenchMode(CFG* cfg, OPTIONS* options)
+{
+    return RunBench(cfg, options->benchPreset, stdout, stderr) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-// --- DESTINATION (DEST) FUNCTIONS ---
-// Destination initializer
-DEST* InitDest(WIN* win, Color color, int width)
+// Headless games for every combination of a parameter sweep - CSV on stdout, throughput on stderr
+int RunBatchMode(CFG* cfg, OPTIONS* options)
 {
-    DEST* dest = (DEST*)malloc(sizeof(DEST));
-    dest->win = win;
-    dest->color = color;
-    dest->width = width;
-    dest->height = 1;   // single row
-    dest->x = (win->cols - dest->width) / 2;
-    dest->y = 1;
-    return dest;
+    SWEEP sweep;
+    if (LoadSweep(&sweep, cfg, options->batch, stderr) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    int threads = options->threads > 0 ? options->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    BATCH* batch = RunBatch(cfg, &sweep, options->headless, options->seed, threads > 0 ? threads : 1);
+    PrintBatchCsv(batch, stdout);
+    double games = (double)batch->nPoints * batch->games;
+    fprintf(stderr, "batch: %d points x %d games on %d threads in %.2f s (%.0f games/s)\n",
+        batch->nPoints, batch->games, batch->nWorkers, batch->seconds, batch->seconds > 0 ? games / batch->seconds : 0.0);
+    FreeBatch(batch);
+    return EXIT_SUCCESS;
 }
 
-void PrintDest(DEST* dest)
+// Replay a recording headlessly and check that it ends in the recorded state
+int RunReplayMode(CFG* cfg, OPTIONS* options)
 {
-    wattron(dest->win->window, COLOR_PAIR(dest->color));
-    for (int y = 0; y < dest->height; y++)
+    REPLAY* replay = OpenReplay(options->replay);
+    if (!replay)
     {
-        for (int x = 0; x < dest->width; x++)
-        {
-            mvwprintw(dest->win->window, dest->y + y, dest->x + x, " ");
-        }
+        fprintf(stderr, "Error reading the recording %s.\n", options->replay);
+        return EXIT_FAILURE;
     }
-    wattron(dest->win->window, COLOR_PAIR(dest->win->color));
-    wrefresh(dest->win->window);
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    int ok = VerifyReplay(replay, cfg, sprites, stdout);
+    FreeSpriteAtlas(sprites);
+    CloseReplay(replay);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-// Returns 1 if the frog has reached the destination, 0 otherwise
-int DestReached(OBJ* frog, DEST* dest)
+// Replay viewer status - frame counter and the viewer keys on the bottom border of the status window
+void PrintViewStatus(WIN* statusWin, SIM* sim, REPLAY* replay, int paused)
 {
-    return (frog->y == dest->y && frog->x == dest->x) ? 1 : 0;
+    mvwprintw(statusWin->window, statusWin->rows - 1, 2, " %s %5d/%d | space: play/pause , . : step [ ] : seek q: quit ",
+        paused ? "Paused " : "Playing", sim->timer->frameNo, replay->header->frames);
+    wnoutrefresh(statusWin->window);
+    doupdate();
 }
 
-// --- TIMER FUNCTIONS ---
-// TIMER initializer
-TIMER* InitTimer(TIMING_CFG* cfg)
+// Watch a recording - play, pause, step and seek through it
+void View(RENDERER* renderer, WIN* statusWin, SIM* sim, REPLAY* replay)
 {
-    TIMER* timer = (TIMER*)malloc(sizeof(TIMER));
-    timer->frameNo = 1;
-    timer->frameTime = cfg->frameTime;
-    timer->timeLeft = cfg->initialTime / 1.0;
-    return timer;
+    PACER pacer;
+    InitPacer(&pacer, sim->timer->frameTime, 0);
+    int paused = 0;
+    int key = NO_KEY;
+    while (key != 'q')
+    {
+        WaitPacer(&pacer);
+        DueSteps(&pacer);   // one frame per wake-up, a slow seek does not make the playback race to catch up
+        int target = sim->timer->frameNo;
+        key = wgetch(statusWin->window);
+        switch (key)
+        {
+            case ' ':
+                paused = !paused;
+                break;
+            case ',':
+                target -= 1;
+                paused = 1;
+                break;
+            case '.':
+                target += 1;
+                paused = 1;
+                break;
+            case '[':
+                target -= KEYFRAME_INTERVAL;
+                break;
+            case ']':
+                target += KEYFRAME_INTERVAL;
+                break;
+            default:
+                if (!paused && sim->result == RUNNING)
+                {
+                    target += 1;
+                }
+        }
+        if (target == sim->timer->frameNo + 1 && sim->result == RUNNING)
+        {
+            StepReplay(replay, sim);    // the last frame ends the game without advancing the frame number
+            RenderFrame(renderer, sim);
+        }
+        else
+        {
+            target = target < 1 ? 1 : (target > replay->header->frames ? replay->header->frames : target);
+            if (target != sim->timer->frameNo)
+            {
+                SeekReplay(replay, sim, target);
+                RenderFrame(renderer, sim);
+            }
+        }
+        PrintViewStatus(statusWin, sim, replay, paused || sim->result != RUNNING);
+    }
 }
 
-int UpdateTimer(TIMER* timer, WIN* win, int initialTime)
+// Replay viewer
+int RunViewMode(CFG* cfg, OPTIONS* options)
 {
-    timer->frameNo++;
-    timer->timeLeft = initialTime - (timer->frameNo * timer->frameTime / 1000.0);
-    if (timer->timeLeft < timer->frameTime / 1000.0)
+    REPLAY* replay = OpenReplay(options->view);
+    if (!replay || replay->header->cfgHash != HashCfg(cfg))
     {
-        timer->timeLeft = 0;
+        fprintf(stderr, "Error reading the recording %s or it was recorded with a different config.\n", options->view);
+        return EXIT_FAILURE;
     }
-    else
+
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    ARENA* arena = InitArena(SimArenaSize(cfg));
+    SIM* sim = InitReplaySim(replay, cfg, sprites, arena);
+    if (!sim)
     {
-        usleep(timer->frameTime * 1000);
+        fprintf(stderr, "Error reading the recording %s - its keyframes do not fit the config.\n", options->view);
+        FreeArena(arena);
+        FreeSpriteAtlas(sprites);
+        CloseReplay(replay);
+        return EXIT_FAILURE;
     }
-    PrintTime(win, timer->timeLeft);
-    return timer->timeLeft == 0 ? 1 : 0; // 1 if time has elapsed, 0 otherwise    
+
+    WINDOW* mainWindow = InitGame();
+    int viewRows = ViewRows(cfg);
+    WIN* playableWin = InitWin(mainWindow, viewRows, cfg->area->cols, cfg->area->offy, cfg->area->offx, COLOR_PLAYABLE, DELAY_ON);
+    WIN* statusWin = InitWin(mainWindow, cfg->area->statusRows, cfg->area->cols, viewRows + cfg->area->offy, cfg->area->offx, COLOR_STATUS, DELAY_OFF);
+
+    InitStatus(statusWin);
+    RENDERER* renderer = InitRenderer(playableWin, statusWin, sim);
+    View(renderer, statusWin, sim, replay);
+
+    Cleanup(playableWin, statusWin, mainWindow, arena);
+    FreeRenderer(renderer);
+    FreeSpriteAtlas(sprites);
+    CloseReplay(replay);
+    return EXIT_SUCCESS;
 }
 
+// Shared game for the clients of a Unix socket - runs until interrupted, log on stderr
+int RunServerMode(CFG* cfg, OPTIONS* options)
+{
+    return RunServer(cfg, options->server, options->seed, stderr) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-// --- MAIN LOOP ---
-GameResult Play(WIN* statusWin, OBJ* frog, CAR** cars, DEST* dest, TIMER* timer, CFG* cfg)
+// Show the result of the own round on the bottom border of the status window until the next round
+void PrintRoundResult(WIN* statusWin, GameResult result)
 {
-    int key;
-    while ((key = wgetch(statusWin->window)) != cfg->controls->quit)
+    DrawBox(statusWin);
+    if (result != RUNNING)
     {
-        flushinp(); // clear input buffer
-        if (key != ERR)
-        {
-            MoveFrog(frog, cfg->controls, key, cfg->frog->moveFactor, timer->frameNo);
-        }
-        for (int i = 0; i < cfg->cars->nCars; i++)
+        char text[128];
+        snprintf(text, sizeof(text), " %s Waiting for the next round... ", ResultMessage(result));
+        DrawText(statusWin, statusWin->rows - 1, 2, text, statusWin->cols - 4, statusWin->color);
+    }
+}
+
+// Thin client - forwards the keys to the server as they are typed and draws the game whenever ticks have arrived
+// Keys are single bytes read straight from the terminal, like the input thread of the local game
+void Follow(RENDERER* renderer, WIN* statusWin, SIM* mirror, CONNECTION* connection)
+{
+    int quit = mirror->cfg->controls->quit;
+    struct pollfd fds[2] = { { connection->fd, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+    int shown = RUNNING;
+    while (1)
+    {
+        if (poll(fds, 2, -1) < 0)
         {
-            MoveCar(cars[i], timer->frameNo);
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
         }
-        PrintDest(dest);
-        PrintObj(frog);  // force overlapping car lanes
-        PrintPosition(statusWin, frog);
-        if (DestReached(frog, dest))
+        if (fds[1].revents & POLLIN)
         {
-            return SUCCESS;
+            unsigned char keys[64];
+            ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+            for (ssize_t i = 0; i < n; i++)
+            {
+                if (SendKey(connection, keys[i]) != 0 || keys[i] == quit)
+                {
+                    return;
+                }
+            }
         }
-        for (int i = 0; i < cfg->cars->nCars; i++)
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
         {
-            if (Collision(frog, cars[i]->obj))
+            int ticks = ReceiveState(connection, mirror);
+            if (ticks < 0)
+            {
+                return;     // the server has gone
+            }
+            if (connection->result != shown)
             {
-                return FAILURE;
+                shown = connection->result;
+                PrintRoundResult(statusWin, shown);
+            }
+            if (ticks > 0)
+            {
+                RenderFrame(renderer, mirror);
             }
         }
-        if (UpdateTimer(timer, statusWin, cfg->timing->initialTime))
+    }
+}
+
+// Play or watch the game of a server - nothing is simulated here, the server's state is drawn as it arrives
+int RunClientMode(CFG* cfg, OPTIONS* options)
+{
+    CONNECTION* connection = Connect(options->connect, options->spectate);
+    if (!connection || AwaitWelcome(connection, cfg, 2000) != 0)
+    {
+        fprintf(stderr, "Error connecting to the server at %s or it runs a different config.\n", options->connect);
+        if (connection)
         {
-            return TIME_OVER;
+            Disconnect(connection);
         }
+        return EXIT_FAILURE;
     }
-    return INTERRUPTED;
+
+    WINDOW* mainWindow = InitGame();
+    int viewRows = ViewRows(cfg);
+    WIN* playableWin = InitWin(mainWindow, viewRows, cfg->area->cols, cfg->area->offy, cfg->area->offx, COLOR_PLAYABLE, DELAY_ON);
+    WIN* statusWin = InitWin(mainWindow, cfg->area->statusRows, cfg->area->cols, viewRows + cfg->area->offy, cfg->area->offx, COLOR_STATUS, DELAY_OFF);
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    ARENA* arena = InitArena(SimArenaSize(cfg));
+    SIM* mirror = InitSim(cfg, sprites, 0, arena);  // the cars and the clock are overwritten by the ticks
+    mirror->frog->y = NET_GONE;     // until the first tick
+
+    ANSI_TERM* ansi = NULL;
+    if (options->ansi)
+    {
+        ansi = InitAnsiTerm(STDOUT_FILENO, LINES, COLS);
+        InitAnsiColors(ansi);
+        playableWin->ansi = ansi;
+        statusWin->ansi = ansi;
+        CleanWin(playableWin);
+        CleanWin(statusWin);
+    }
+    InitStatus(statusWin);
+    RENDERER* renderer = InitRenderer(playableWin, statusWin, mirror);
+    SetOtherFrogs(renderer, connection->frogs, NET_MAX_FROGS);
+    cbreak();
+    Follow(renderer, statusWin, mirror, connection);
+
+    long ticks = connection->ticks;
+    long bytes = connection->bytes;
+    Disconnect(connection);
+    Cleanup(playableWin, statusWin, mainWindow, arena);
+    PrintRenderStats(renderer, stdout);
+    if (ansi)
+    {
+        FreeAnsiTerm(ansi);
+    }
+    fprintf(stdout, "ticks received: %ld (%.1f bytes per tick)\n", ticks, ticks ? (double)bytes / ticks : 0.0);
+    FreeRenderer(renderer);
+    FreeSpriteAtlas(sprites);
+    return EXIT_SUCCESS;
 }
 
+void Usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [--seed N] [--record FILE | --headless [GAMES] | --batch SWEEP [GAMES] [--threads N] | --bench [PRESET] | --solve [GAMES] | --replay FILE | --view FILE | --server SOCKET | --connect SOCKET [--spectate]] [--endless] [--autopilot] [--watch] [--rewind [SECONDS]] [--idle] [--fps N] [--profile FILE] [--backend ncurses|ansi]\n", program);
+    exit(EXIT_FAILURE);
+}
 
-// --- CLEANUP ---
-void Cleanup(WIN* playableWin, WIN* statusWin, WINDOW* mainWindow, OBJ* frog, CAR** cars, DEST* dest, TIMER* timer)
+void ParseOptions(OPTIONS* options, int argc, char** argv)
 {
-    delwin(playableWin->window);
-    free(playableWin);
-    delwin(statusWin->window);
-    free(statusWin);
-    delwin(mainWindow);
-    free(frog);
-    for (int i = 0; i < sizeof(cars) / sizeof(CAR*); i++)
+    memset(options, 0, sizeof(OPTIONS));
+    options->seed = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; i++)
     {
-        free(cars[i]->obj);
-        free(cars[i]);
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--headless") == 0)
+        {
+            options->headless = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 1000;
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            options->batch = argv[++i];
+            options->headless = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 1000;
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            options->bench = 1;
+            options->benchPreset = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : NULL;
+        }
+        else if (strcmp(argv[i], "--solve") == 0)
+        {
+            options->solve = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 1000;
+        }
+        else if (strcmp(argv[i], "--autopilot") == 0)
+        {
+            options->autopilot = 1;
+        }
+        else if (strcmp(argv[i], "--watch") == 0)
+        {
+            options->watch = 1;
+        }
+        else if (strcmp(argv[i], "--idle") == 0)
+        {
+            options->idle = 1;
+        }
+        else if (strcmp(argv[i], "--rewind") == 0)
+        {
+            options->rewind = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 30;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            options->threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            options->fps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc && (strcmp(argv[i + 1], "ncurses") == 0 || strcmp(argv[i + 1], "ansi") == 0))
+        {
+            options->ansi = strcmp(argv[++i], "ansi") == 0;
+        }
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            options->server = argv[++i];
+        }
+        else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc)
+        {
+            options->connect = argv[++i];
+        }
+        else if (strcmp(argv[i], "--spectate") == 0)
+        {
+            options->spectate = 1;
+        }
+        else if (strcmp(argv[i], "--endless") == 0)
+        {
+            options->endless = 1;
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            options->profile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            options->record = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            options->replay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc)
+        {
+            options->view = argv[++i];
+        }
+        else
+        {
+            Usage(argv[0]);
+        }
     }
-    free(cars);
-    free(dest);
-    free(timer); // TODO: add the rest of pointers to the cleanup function
-    endwin();
-    refresh();
 }
 
-
-// --- MAIN PROGRAM ---
-int main()
+int main(int argc, char** argv)
 {
-    srand(time(NULL));
-
-    WINDOW* mainWindow = InitGame();
-    Welcome(mainWindow);
+    OPTIONS options;
+    ParseOptions(&options, argc, argv);
 
     CFG* cfg = InitCfg();
-    WIN* playableWin = InitWin(mainWindow, cfg->area->playableRows, cfg->area->cols, cfg->area->offy, cfg->area->offx, COLOR_PLAYABLE, DELAY_ON);
-    WIN* statusWin = InitWin(mainWindow, cfg->area->statusRows, cfg->area->cols, cfg->area->playableRows + cfg->area->offy, cfg->area->offx, COLOR_STATUS, DELAY_OFF);
-    TIMER* timer = InitTimer(cfg->timing);
-    OBJ* frog = InitFrog(playableWin, COLOR_FROG, cfg->frog);
-    CAR** cars = GenerateCars(playableWin, COLOR_CAR, cfg->cars, cfg->frog->height);
-    DEST* destination = InitDest(playableWin, COLOR_DEST, cfg->frog->width); // destination is a single row of the frog's width
-
-    InitStatus(statusWin, timer, frog);
-
-    GameResult result = Play(statusWin, frog, cars, destination, timer, cfg);
-    EndGame(statusWin, result, cfg->timing->quitTime);
-    Cleanup(playableWin, statusWin, mainWindow, frog, cars, destination, timer);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    cfg->area->endless |= options.endless;  // part of the config - recordings of the endless road replay only on it
+    if (options.replay)
+    {
+        return RunReplayMode(cfg, &options);
+    }
+    if (options.view)
+    {
+        return RunViewMode(cfg, &options);
+    }
+    if (options.server)
+    {
+        return RunServerMode(cfg, &options);
+    }
+    if (options.connect)
+    {
+        return RunClientMode(cfg, &options);
+    }
+    if ((options.solve > 0 || options.autopilot) && cfg->area->endless)
+    {
+        fprintf(stderr, "The solver does not play the endless road.\n");
+        return EXIT_FAILURE;
+    }
+    if (options.watch && options.record)
+    {
+        fprintf(stderr, "A recording cannot follow a reloaded config.\n");
+        return EXIT_FAILURE;
+    }
+    if (options.idle && options.fps > 0)
+    {
+        fprintf(stderr, "Idle pacing renders whenever the screen changes - it takes no frame rate.\n");
+        return EXIT_FAILURE;
+    }
+    if (options.rewind > 0 && (options.record || options.autopilot))
+    {
+        fprintf(stderr, "A rewound game can neither be recorded nor played by the solver.\n");
+        return EXIT_FAILURE;
+    }
+    if (options.solve > 0)
+    {
+        return RunSolveMode(cfg, &options);
+    }
+    if (options.bench)
+    {
+        return RunBenchMode(cfg, &options);
+    }
+    if (options.batch)
+    {
+        return RunBatchMode(cfg, &options);
+    }
+    if (options.headless > 0)
+    {
+        return RunHeadlessMode(cfg, &options);
+    }
+    return RunGame(cfg, &options);
+}
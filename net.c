@@ -0,0 +1,67 @@
+// net.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "net.h"
+
+
+// --- BUFFER FUNCTIONS ---
+void PutBytes(NET_BUFFER* buffer, const void* data, size_t size)
+{
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+        while (buffer->size + size > capacity)
+        {
+            capacity *= 2;
+        }
+        buffer->data = (unsigned char*)realloc(buffer->data, capacity);
+        if (buffer->data == NULL)
+        {
+            fprintf(stderr, "Error allocating network buffer.\n");
+            exit(EXIT_FAILURE);
+        }
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+void PutU8(NET_BUFFER* buffer, uint8_t value)
+{
+    PutBytes(buffer, &value, sizeof(value));
+}
+
+void PutU16(NET_BUFFER* buffer, uint16_t value)
+{
+    PutBytes(buffer, &value, sizeof(value));
+}
+
+size_t BeginMessage(NET_BUFFER* buffer, MessageType type)
+{
+    size_t offset = buffer->size;
+    uint32_t length = 0;
+    PutBytes(buffer, &length, sizeof(length));
+    PutU8(buffer, (uint8_t)type);
+    return offset;
+}
+
+void EndMessage(NET_BUFFER* buffer, size_t offset)
+{
+    uint32_t length = (uint32_t)(buffer->size - offset - sizeof(uint32_t));
+    memcpy(buffer->data + offset, &length, sizeof(length));
+}
+
+void ConsumeBytes(NET_BUFFER* buffer, size_t size)
+{
+    memmove(buffer->data, buffer->data + size, buffer->size - size);
+    buffer->size -= size;
+}
+
+void FreeBuffer(NET_BUFFER* buffer)
+{
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
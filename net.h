@@ -0,0 +1,56 @@
+// net.h
+#ifndef NET_H
+#define NET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- PROTOCOL ---
+// Server to client: every message is a uint32 length (of what follows), a type byte and the payload
+// Client to server: two bytes, the type and its value
+// Integers are sent in host byte order - the socket never leaves the machine
+#define NET_HEADER 5            // length and type
+#define NET_MAX_FROGS 1024      // players and spectators of a server
+#define NET_SPECTATOR 0xFFFF    // player id of a client without a frog
+#define NET_GONE (-32768)       // y of a frog that is not on the road (left, or out of the round)
+#define NET_MAX_MESSAGE (1 << 24)   // a client drops the connection on anything longer
+
+typedef enum {
+    MSG_WELCOME = 1,    // uint64 cfg hash, uint16 player id, uint16 cars
+    MSG_TICK,           // TICK_HEADER, then nCars x { uint16 car, int16 x } and nFrogs x { uint16 id, int16 x, int16 y }
+    MSG_RESULT,         // uint8 GameResult - the round of the receiving player has ended
+    MSG_HELLO,          // client: 0 to play, 1 to spectate - the first message of a client
+    MSG_KEY             // client: a key press, one byte
+} MessageType;
+
+// Tick - the cars and frogs whose position has changed since the previous tick (all of them in a full tick)
+typedef struct {
+    int32_t frame;
+    float timeLeft;
+    int16_t destX, destY;
+    uint16_t nCars;
+    uint16_t nFrogs;
+    uint8_t full;       // 1 if every car and frog is listed - sent to new clients
+    uint8_t reserved[3];
+} TICK_HEADER;
+
+// Growable byte buffer for encoding and queueing messages
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} NET_BUFFER;
+
+// --- BUFFER FUNCTIONS ---
+void PutBytes(NET_BUFFER* buffer, const void* data, size_t size);
+void PutU8(NET_BUFFER* buffer, uint8_t value);
+void PutU16(NET_BUFFER* buffer, uint16_t value);
+// Start a message - returns its offset for EndMessage
+size_t BeginMessage(NET_BUFFER* buffer, MessageType type);
+// Fill in the length of the message started at offset
+void EndMessage(NET_BUFFER* buffer, size_t offset);
+// Drop the first size bytes (sent or parsed)
+void ConsumeBytes(NET_BUFFER* buffer, size_t size);
+void FreeBuffer(NET_BUFFER* buffer);
+
+#endif // NET_H
@@ -0,0 +1,113 @@
+// pacer.c
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include "pacer.h"
+
+
+// --- PACER FUNCTIONS ---
+int64_t NowNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void InitPacer(PACER* pacer, int frameTime, int renderFps)
+{
+    pacer->step = (int64_t)frameTime * 1000000;
+    pacer->renderPeriod = renderFps > 0 ? 1000000000 / renderFps : 0;
+    pacer->nextStep = NowNs();
+    pacer->nextRender = pacer->nextStep;
+    pacer->wakeAt = pacer->nextStep;
+    pacer->steps = 0;
+    pacer->renders = 0;
+    pacer->overruns = 0;
+    pacer->dropped = 0;
+    pacer->wakeups = 0;
+}
+
+void SetPacerStep(PACER* pacer, int frameTime)
+{
+    pacer->step = (int64_t)frameTime * 1000000;
+}
+
+void WaitPacer(PACER* pacer)
+{
+    struct timespec deadline;
+    deadline.tv_sec = pacer->nextStep / 1000000000;
+    deadline.tv_nsec = pacer->nextStep % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);  // absolute, so a signal does not stretch the wait
+    pacer->wakeAt = pacer->nextStep;
+    pacer->wakeups++;
+}
+
+int WaitPacerIdle(PACER* pacer, int steps, int fd)
+{
+    pacer->wakeAt = pacer->nextStep + (int64_t)(steps > 1 ? steps - 1 : 0) * pacer->step;
+    pacer->wakeups++;
+    struct pollfd fds[1] = { { fd, POLLIN, 0 } };
+    while (1)
+    {
+        int64_t left = pacer->wakeAt - NowNs();   // recomputed after a signal, so it does not stretch the wait
+        if (left <= 0)
+        {
+            return 0;
+        }
+        int ready = poll(fds, fd >= 0 ? 1 : 0, (int)((left + 999999) / 1000000));   // rounded up - never wakes before the deadline
+        if (ready > 0)
+        {
+            return 1;
+        }
+        if (ready == 0 || errno != EINTR)
+        {
+            return 0;
+        }
+    }
+}
+
+int DueSteps(PACER* pacer)
+{
+    int64_t now = NowNs();
+    if (now < pacer->nextStep)
+    {
+        return 0;
+    }
+    int64_t due = (now - pacer->nextStep) / pacer->step + 1;
+    int64_t planned = pacer->wakeAt > pacer->nextStep ? (pacer->wakeAt - pacer->nextStep) / pacer->step + 1 : 1;
+    pacer->nextStep += due * pacer->step;   // stays on the grid even when steps are dropped
+    if (due > planned)
+    {
+        pacer->overruns++;
+    }
+    if (due > planned - 1 + PACER_MAX_CATCH_UP)
+    {
+        pacer->dropped += due - (planned - 1 + PACER_MAX_CATCH_UP);
+        due = planned - 1 + PACER_MAX_CATCH_UP;
+    }
+    pacer->steps += due;
+    return (int)due;
+}
+
+int RenderDue(PACER* pacer)
+{
+    int64_t now = NowNs();
+    if (now < pacer->nextRender)
+    {
+        return 0;
+    }
+    if (pacer->renderPeriod > 0)
+    {
+        pacer->nextRender += ((now - pacer->nextRender) / pacer->renderPeriod + 1) * pacer->renderPeriod;
+    }
+    pacer->renders++;
+    return 1;
+}
+
+void PrintPacerStats(PACER* pacer, FILE* out)
+{
+    fprintf(out, "steps: %ld\n", pacer->steps);
+    fprintf(out, "rendered frames: %ld\n", pacer->renders);
+    fprintf(out, "overruns: %ld (%ld steps dropped)\n", pacer->overruns, pacer->dropped);
+    fprintf(out, "wake-ups: %ld\n", pacer->wakeups);
+}
@@ -0,0 +1,43 @@
+// pacer.h
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define PACER_MAX_CATCH_UP 4    // simulation steps run back to back after an overrun, the rest of the backlog is dropped
+
+// Frame pacer - fixed simulation timestep on absolute CLOCK_MONOTONIC deadlines, so the work of a frame
+// does not add up to the frame period, with rendering at its own (lower) rate
+typedef struct {
+    int64_t step;           // nanoseconds per simulation step
+    int64_t renderPeriod;   // nanoseconds between rendered frames
+    int64_t nextStep;       // deadline of the next simulation step - always start + k * step
+    int64_t nextRender;
+    int64_t wakeAt;         // deadline of the last wait - the steps due by then were meant to run together
+    long steps;             // simulation steps run
+    long renders;
+    long overruns;          // wake-ups that found more than one step due
+    long dropped;           // steps skipped by the catch-up cap
+    long wakeups;
+} PACER;
+
+// --- PACER FUNCTIONS ---
+// Nanoseconds on CLOCK_MONOTONIC
+int64_t NowNs();
+// Simulation step of frameTime milliseconds, rendering at renderFps (0 to render after every step) - the first step is due now
+void InitPacer(PACER* pacer, int frameTime, int renderFps);
+// Change the step to frameTime milliseconds - the step already due keeps its deadline, the grid starts from it
+void SetPacerStep(PACER* pacer, int frameTime);
+// Sleep until the next step is due
+void WaitPacer(PACER* pacer);
+// Idle pacing - sleep until the given number of steps is due (the last one of them) or fd is readable (-1 for none)
+// 1 if woken by fd
+int WaitPacerIdle(PACER* pacer, int steps, int fd);
+// Number of simulation steps due now (at most PACER_MAX_CATCH_UP more than the wait was meant for)
+int DueSteps(PACER* pacer);
+// 1 if a frame should be rendered now
+int RenderDue(PACER* pacer);
+void PrintPacerStats(PACER* pacer, FILE* out);
+
+#endif // PACER_H
@@ -0,0 +1,116 @@
+// profile.c
+#include <string.h>
+#include "profile.h"
+#include "pacer.h"
+
+// Names of the phases in the summary, in ProfilePhase order
+const char* PHASE_NAMES[PROFILE_PHASES] = { "input", "frog", "cars", "collision", "render", "sleep", "frame" };
+
+
+// --- HISTOGRAM FUNCTIONS ---
+// Values below 1 << PROFILE_SUB_BITS have a bucket each, above that every power of two is split into equal sub-buckets
+int HistogramBucket(int64_t value)
+{
+    if (value < (1 << PROFILE_SUB_BITS))
+    {
+        return value < 0 ? 0 : (int)value;
+    }
+    int shift = 63 - __builtin_clzll((uint64_t)value) - PROFILE_SUB_BITS;
+    return ((shift + 1) << PROFILE_SUB_BITS) + (int)((value >> shift) & ((1 << PROFILE_SUB_BITS) - 1));
+}
+
+// Largest value of a bucket
+int64_t BucketValue(int bucket)
+{
+    if (bucket < (1 << PROFILE_SUB_BITS))
+    {
+        return bucket;
+    }
+    int shift = (bucket >> PROFILE_SUB_BITS) - 1;
+    int64_t mantissa = (1 << PROFILE_SUB_BITS) + (bucket & ((1 << PROFILE_SUB_BITS) - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void RecordSample(HISTOGRAM* histogram, int64_t value, int64_t budget)
+{
+    histogram->counts[HistogramBucket(value)]++;
+    histogram->count++;
+    histogram->total += value;
+    histogram->max = value > histogram->max ? value : histogram->max;
+    histogram->overruns += value > budget;
+}
+
+int64_t HistogramPercentile(HISTOGRAM* histogram, double fraction)
+{
+    long rank = (long)(fraction * histogram->count + 0.5);
+    rank = rank < 1 ? 1 : rank;
+    long seen = 0;
+    for (int i = 0; i < PROFILE_BUCKETS; i++)
+    {
+        seen += histogram->counts[i];
+        if (seen >= rank)
+        {
+            int64_t value = BucketValue(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+
+// --- PROFILER FUNCTIONS ---
+void InitProfiler(PROFILER* profiler, int frameTime)
+{
+    memset(profiler, 0, sizeof(PROFILER));
+    profiler->budget = (int64_t)frameTime * 1000000;
+    profiler->mark = NowNs();
+    profiler->frameStart = profiler->mark;
+}
+
+void SetProfilerBudget(PROFILER* profiler, int frameTime)
+{
+    profiler->budget = (int64_t)frameTime * 1000000;
+}
+
+void StartProfileFrame(PROFILER* profiler)
+{
+    profiler->mark = NowNs();
+    profiler->frameStart = profiler->mark;
+    profiler->slept = 0;
+}
+
+void EndPhase(PROFILER* profiler, ProfilePhase phase)
+{
+    int64_t now = NowNs();
+    RecordSample(&profiler->phases[phase], now - profiler->mark, profiler->budget);
+    if (phase == PHASE_SLEEP)
+    {
+        profiler->slept += now - profiler->mark;
+    }
+    profiler->mark = now;
+}
+
+void EndProfileFrame(PROFILER* profiler)
+{
+    int64_t now = NowNs();
+    RecordSample(&profiler->phases[PHASE_FRAME], now - profiler->frameStart - profiler->slept, profiler->budget);
+    profiler->mark = now;
+}
+
+void ProfileLatency(PROFILER* profiler, int64_t since)
+{
+    RecordSample(&profiler->latency, NowNs() - since, profiler->budget);
+}
+
+void PrintProfileCsv(PROFILER* profiler, FILE* out)
+{
+    fprintf(out, "phase,count,mean_ns,p50_ns,p99_ns,max_ns,over_budget\n");
+    for (int i = 0; i <= PROFILE_PHASES; i++)
+    {
+        HISTOGRAM* histogram = i < PROFILE_PHASES ? &profiler->phases[i] : &profiler->latency;
+        fprintf(out, "%s,%ld,%.0f,%lld,%lld,%lld,%ld\n", i < PROFILE_PHASES ? PHASE_NAMES[i] : "input_to_pixel", histogram->count,
+            histogram->count > 0 ? (double)histogram->total / histogram->count : 0.0,
+            (long long)HistogramPercentile(histogram, 0.50), (long long)HistogramPercentile(histogram, 0.99),
+            (long long)histogram->max, histogram->overruns);
+    }
+}
@@ -0,0 +1,62 @@
+// profile.h
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define PROFILE_SUB_BITS 4  // linear sub-buckets per power of two are 1 << PROFILE_SUB_BITS - values within ~6%
+#define PROFILE_BUCKETS ((64 - PROFILE_SUB_BITS + 1) << PROFILE_SUB_BITS)  // any int64 nanoseconds
+#define PROFILE_KEY 'p'     // shows and hides the overlay
+
+// Timed phases of a frame - PHASE_FRAME is the whole frame but the sleep
+typedef enum {
+    PHASE_INPUT,
+    PHASE_FROG,
+    PHASE_CARS,
+    PHASE_COLLISION,
+    PHASE_RENDER,
+    PHASE_SLEEP,
+    PHASE_FRAME,
+    PROFILE_PHASES
+} ProfilePhase;
+
+// Log-linear histogram of durations in nanoseconds (HDR style) - fixed size, O(1) recording
+typedef struct {
+    uint32_t counts[PROFILE_BUCKETS];
+    long count;
+    int64_t total;
+    int64_t max;
+    long overruns;      // samples longer than the frame budget
+} HISTOGRAM;
+
+// Frame profiler - phases are timed from mark to mark, so every phase costs one clock read
+typedef struct {
+    HISTOGRAM phases[PROFILE_PHASES];
+    HISTOGRAM latency;  // input to pixel - from reading a key to the end of the frame that shows its effect
+    int64_t budget;     // nanoseconds per frame
+    int64_t mark;       // end of the last timed phase
+    int64_t frameStart;
+    int64_t slept;      // sleep of the current frame, not counted in PHASE_FRAME
+    int visible;        // 1 if the overlay is shown
+} PROFILER;
+
+// --- PROFILER FUNCTIONS ---
+void InitProfiler(PROFILER* profiler, int frameTime);
+// Change the frame budget to frameTime milliseconds - the samples so far stay as counted
+void SetProfilerBudget(PROFILER* profiler, int frameTime);
+// Start a frame - the next phase is timed from now
+void StartProfileFrame(PROFILER* profiler);
+// End the given phase now
+void EndPhase(PROFILER* profiler, ProfilePhase phase);
+// End the frame - records its busy time
+void EndProfileFrame(PROFILER* profiler);
+// A key read at the given time (NowNs) is on the screen now
+void ProfileLatency(PROFILER* profiler, int64_t since);
+// Value below which the given fraction of the samples lies (upper bound of its bucket)
+int64_t HistogramPercentile(HISTOGRAM* histogram, double fraction);
+// One CSV line per phase and one for the input-to-pixel latency - count, mean, p50, p99 and max in nanoseconds,
+// samples over the frame budget
+void PrintProfileCsv(PROFILER* profiler, FILE* out);
+
+#endif // PROFILE_H
@@ -0,0 +1,532 @@
+// render.c
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "render.h"
+
+
+// --- IO COUNTERS ---
+// Read the bytes and write syscalls of the process so far
+void ReadIoCount(int fd, IO_COUNT* count)
+{
+    count->bytes = 0;
+    count->syscalls = 0;
+    char buffer[512];
+    if (fd < 0 || lseek(fd, 0, SEEK_SET) != 0)
+    {
+        return;
+    }
+    ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    if (length <= 0)
+    {
+        return;
+    }
+    buffer[length] = '\0';
+    char* field;
+    if ((field = strstr(buffer, "wchar:")) != NULL)
+    {
+        count->bytes = atol(field + strlen("wchar:"));
+    }
+    if ((field = strstr(buffer, "syscw:")) != NULL)
+    {
+        count->syscalls = atol(field + strlen("syscw:"));
+    }
+}
+
+
+// --- WIN FUNCTIONS ---
+// Foreground and background of every Color - COLOR_MAIN is pair 0, which ncurses keeps at the terminal defaults
+const short GAME_PALETTE[][2] = {
+    { -1, -1 },
+    { COLOR_BLACK, COLOR_WHITE },
+    { COLOR_BLACK, COLOR_WHITE },
+    { COLOR_GREEN, COLOR_WHITE },
+    { COLOR_RED, COLOR_WHITE },
+    { COLOR_GREEN, COLOR_BLUE },
+};
+const int N_PALETTE_PAIRS = sizeof(GAME_PALETTE) / sizeof(GAME_PALETTE[0]);
+
+void InitColors()
+{
+    start_color();
+    for (int i = 1; i < N_PALETTE_PAIRS; i++)
+    {
+        init_pair(i, GAME_PALETTE[i][0], GAME_PALETTE[i][1]);
+    }
+}
+
+void InitAnsiColors(ANSI_TERM* term)
+{
+    for (int i = 0; i < N_PALETTE_PAIRS; i++)
+    {
+        SetAnsiColor(term, i, GAME_PALETTE[i][0], GAME_PALETTE[i][1]);   // curses color numbers are the ANSI ones
+    }
+}
+
+void DrawText(WIN* win, int y, int x, const char* text, int length, Color color)
+{
+    if (win->ansi)
+    {
+        if (y >= 0 && y < win->rows && x < win->cols)
+        {
+            AnsiText(win->ansi, win->y + y, win->x + x, text, length < win->cols - x ? length : win->cols - x, color);
+        }
+        return;
+    }
+    wattron(win->window, COLOR_PAIR(color));
+    mvwaddnstr(win->window, y, x, text, length);
+    wattron(win->window, COLOR_PAIR(win->color));
+}
+
+void DrawHLine(WIN* win, int y, int x, char glyph, int length, Color color)
+{
+    if (win->ansi)
+    {
+        if (y >= 0 && y < win->rows && x < win->cols)
+        {
+            AnsiFill(win->ansi, win->y + y, win->x + x, glyph, length < win->cols - x ? length : win->cols - x, color);
+        }
+        return;
+    }
+    wattron(win->window, COLOR_PAIR(color));
+    mvwhline(win->window, y, x, glyph, length);
+    wattron(win->window, COLOR_PAIR(win->color));
+}
+
+void DrawBox(WIN* win)
+{
+    if (!win->ansi)
+    {
+        box(win->window, 0, 0);
+        return;
+    }
+    int color = win->color | ANSI_ACS;  // l k m j q x are the corners and lines of the DEC line drawing set
+    ANSI_TERM* term = win->ansi;
+    AnsiFill(term, win->y, win->x + 1, 'q', win->cols - 2, color);
+    AnsiFill(term, win->y + win->rows - 1, win->x + 1, 'q', win->cols - 2, color);
+    for (int row = 1; row < win->rows - 1; row++)
+    {
+        AnsiFill(term, win->y + row, win->x, 'x', 1, color);
+        AnsiFill(term, win->y + row, win->x + win->cols - 1, 'x', 1, color);
+    }
+    AnsiFill(term, win->y, win->x, 'l', 1, color);
+    AnsiFill(term, win->y, win->x + win->cols - 1, 'k', 1, color);
+    AnsiFill(term, win->y + win->rows - 1, win->x, 'm', 1, color);
+    AnsiFill(term, win->y + win->rows - 1, win->x + win->cols - 1, 'j', 1, color);
+}
+
+void PrintWin(WIN* win, int y, int x, const char* format, ...)
+{
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    DrawText(win, y, x, text, (int)strlen(text), win->color);
+}
+
+void RefreshWin(WIN* win)
+{
+    if (win->ansi)
+    {
+        FlushAnsiTerm(win->ansi);
+    }
+    else
+    {
+        wrefresh(win->window);
+    }
+}
+
+// Cleaning the window (fills it with " ", one call per row)
+void CleanWin(WIN* win)
+{
+    for (int row = 0; row < win->rows; row++)
+    {
+        DrawHLine(win, row, 0, ' ', win->cols, win->color);
+    }
+    DrawBox(win); // add border to outermost rows/cols
+}
+
+
+// --- OBJ FUNCTIONS ---
+// Print a sprite with its top-left corner at x, y - runs of opaque cells only, transparent spaces keep what is below
+// Rows outside the window border are clipped (sprites partly scrolled out of the view)
+void PrintSprite(WIN* win, SPRITE* sprite, int x, int y, Color color)
+{
+    for (int row = 0; row < sprite->height; row++)
+    {
+        if (y + row < 1 || y + row >= win->rows - 1)
+        {
+            continue;
+        }
+        char* cells = sprite->cells + row * sprite->width;
+        unsigned char* opaque = sprite->opaque + row * sprite->width;
+        int col = 0;
+        while (col < sprite->rowLength[row])
+        {
+            if (!opaque[col])
+            {
+                col++;
+                continue;
+            }
+            int run = col;
+            while (run < sprite->rowLength[row] && opaque[run])
+            {
+                run++;
+            }
+            DrawText(win, y + row, x + col, cells + col, run - col, color);
+            col = run;
+        }
+    }
+}
+
+
+// --- DAMAGE FUNCTIONS ---
+int RectOverlaps(RECT* rect, int x, int y, int width, int height)
+{
+    return (x < rect->x + rect->width && rect->x < x + width &&
+        y < rect->y + rect->height && rect->y < y + height) ? 1 : 0;
+}
+
+// Add a damaged region of the world, clipped to the inside of the window border
+void AddDirty(RENDERER* renderer, int x, int y, int width, int height)
+{
+    int xmax = x + width;
+    int ymax = y + height;
+    int top = renderer->viewY + 1;
+    int bottom = renderer->viewY + renderer->playable->rows - 1;
+    x = x < 1 ? 1 : x;
+    y = y < top ? top : y;
+    xmax = xmax > renderer->playable->cols - 1 ? renderer->playable->cols - 1 : xmax;
+    ymax = ymax > bottom ? bottom : ymax;
+    if (x >= xmax || y >= ymax)
+    {
+        return;
+    }
+    RECT* rect = &renderer->dirty[renderer->nDirty++];
+    rect->x = x;
+    rect->y = y;
+    rect->width = xmax - x;
+    rect->height = ymax - y;
+}
+
+// Old and new footprint of a moved object - one region when they touch (objects move by 1), two for a respawned car
+void AddMoved(RENDERER* renderer, int x, int y, int oldX, int oldY, int width, int height)
+{
+    if (oldX == x && oldY == y)
+    {
+        return;
+    }
+    if (abs(x - oldX) > width || abs(y - oldY) > height)
+    {
+        AddDirty(renderer, oldX, oldY, width, height);
+        AddDirty(renderer, x, y, width, height);
+        return;
+    }
+    AddDirty(renderer, oldX < x ? oldX : x, oldY < y ? oldY : y, width + abs(x - oldX), height + abs(y - oldY));
+}
+
+// Repaint the background of a damaged region - empty road, lane lines and destination
+void RepaintRect(RENDERER* renderer, SIM* sim, RECT* rect)
+{
+    WIN* win = renderer->playable;
+    for (int y = rect->y; y < rect->y + rect->height; y++)
+    {
+        DrawHLine(win, y - renderer->viewY, rect->x, renderer->laneRows[y] ? '-' : ' ', rect->width, win->color);
+    }
+
+    DEST* dest = sim->dest;
+    if (RectOverlaps(rect, dest->x, dest->y, dest->width, dest->height))
+    {
+        int x = dest->x > rect->x ? dest->x : rect->x;
+        int xmax = dest->x + dest->width < rect->x + rect->width ? dest->x + dest->width : rect->x + rect->width;
+        int ymax = dest->y + dest->height < rect->y + rect->height ? dest->y + dest->height : rect->y + rect->height;
+        for (int y = dest->y > rect->y ? dest->y : rect->y; y < ymax; y++)
+        {
+            DrawHLine(win, y - renderer->viewY, x, ' ', xmax - x, COLOR_DEST);
+        }
+    }
+}
+
+int Damaged(RENDERER* renderer, int x, int y, int width, int height)
+{
+    for (int i = 0; i < renderer->nDirty; i++)
+    {
+        if (RectOverlaps(&renderer->dirty[i], x, y, width, height))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// --- STATUS FUNCTIONS ---
+// Print a status field only when its text has changed
+void PrintStatusField(WIN* win, int x, char* onScreen, size_t size, const char* text)
+{
+    if (strcmp(onScreen, text) == 0)
+    {
+        return;
+    }
+    int stale = (int)strlen(onScreen) - (int)strlen(text);    // clear leftovers of a longer text
+    PrintWin(win, 1, x, "%s%*s", text, stale > 0 ? stale : 0, "");
+    snprintf(onScreen, size, "%s", text);
+}
+
+void PrintStatus(RENDERER* renderer, SIM* sim)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "Time: %.*f", renderer->timeDecimals, sim->timer->timeLeft);
+    PrintStatusField(renderer->status, 2, renderer->timeText, sizeof(renderer->timeText), text);
+    if (sim->cfg->area->endless)
+    {
+        snprintf(text, sizeof(text), "Distance: %d Checkpoints: %d", SimDistance(sim), sim->checkpoints);
+    }
+    else if (sim->frog->y < 0)
+    {
+        snprintf(text, sizeof(text), "Position: -");   // not on the road - a network client between rounds or spectating
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "Position: x: %d y: %d", sim->frog->x, sim->frog->y);
+    }
+    PrintStatusField(renderer->status, renderer->status->cols / 2 - 10, renderer->positionText, sizeof(renderer->positionText), text);
+}
+
+
+// --- RENDERER FUNCTIONS ---
+// Send all windows to the terminal in a single update and count the output
+void FlushFrame(RENDERER* renderer)
+{
+    IO_COUNT before, after;
+    ANSI_TERM* ansi = renderer->playable->ansi;
+    if (ansi)
+    {
+        before.bytes = ansi->bytes;
+        before.syscalls = ansi->writes;
+        FlushAnsiTerm(ansi);
+        after.bytes = ansi->bytes;
+        after.syscalls = ansi->writes;
+    }
+    else
+    {
+        wnoutrefresh(renderer->playable->window);
+        wnoutrefresh(renderer->status->window);
+        ReadIoCount(renderer->ioFd, &before);
+        doupdate();
+        ReadIoCount(renderer->ioFd, &after);
+    }
+
+    RENDER_STATS* stats = &renderer->stats;
+    stats->frames++;
+    stats->lastBytes = after.bytes - before.bytes;
+    stats->bytes += stats->lastBytes;
+    stats->syscalls += after.syscalls - before.syscalls;
+    if (stats->lastBytes > stats->maxBytes)
+    {
+        stats->maxBytes = stats->lastBytes;
+    }
+}
+
+// Draw the objects over the repainted regions and flush
+void DrawDamaged(RENDERER* renderer, SIM* sim)
+{
+    for (int i = 0; i < renderer->nDirty; i++)
+    {
+        RepaintRect(renderer, sim, &renderer->dirty[i]);
+    }
+    CAR_POOL* cars = sim->cars;
+    int viewY = renderer->viewY;
+    for (int i = renderer->carFrom; i < renderer->carTo; i++)
+    {
+        if (Damaged(renderer, cars->x[i], cars->y[i], cars->width, cars->height))
+        {
+            PrintSprite(renderer->playable, GetSprite(sim->sprites, cars->sprite[i]), cars->x[i], cars->y[i] - viewY, COLOR_CAR);
+        }
+    }
+    for (int i = 0; i < renderer->nOthers; i++)
+    {
+        OBJ* other = &renderer->others[i];    // only the position is used, the size is the game's frog's
+        if (Damaged(renderer, other->x, other->y, sim->frog->width, sim->frog->height))
+        {
+            PrintSprite(renderer->playable, GetSprite(sim->sprites, sim->frog->sprite), other->x, other->y - viewY, COLOR_FROG);
+        }
+    }
+    PrintSprite(renderer->playable, GetSprite(sim->sprites, sim->frog->sprite), sim->frog->x, sim->frog->y - viewY, COLOR_FROG);  // always on top, unchanged cells cost nothing
+    PrintStatus(renderer, sim);
+    FlushFrame(renderer);
+}
+
+// Point the camera at the frog (centered, within the world) and tell the simulation which rows are on the screen
+// 1 if the camera has moved
+int UpdateCamera(RENDERER* renderer, SIM* sim)
+{
+    int rows = renderer->playable->rows;
+    int viewY = sim->frog->y + sim->frog->height / 2 - rows / 2;
+    viewY = viewY > sim->rows - rows ? sim->rows - rows : viewY;
+    viewY = viewY < 0 ? 0 : viewY;
+    int moved = viewY != renderer->viewY;
+    renderer->viewY = viewY;
+    sim->viewY = viewY;
+    sim->viewRows = rows;
+    CarsInRows(sim->cars, viewY, viewY + rows, &renderer->carFrom, &renderer->carTo);
+    return moved;
+}
+
+// Repaint the whole window - the cars coming into view are brought up to date first
+void DamageView(RENDERER* renderer, SIM* sim)
+{
+    CAR_POOL* cars = sim->cars;
+    SyncCars(cars, renderer->carFrom, renderer->carTo);
+    for (int i = renderer->carFrom; i < renderer->carTo; i++)
+    {
+        renderer->carX[i] = cars->x[i];
+    }
+    AddDirty(renderer, 0, renderer->viewY, renderer->playable->cols, renderer->playable->rows);
+}
+
+RENDERER* InitRenderer(WIN* playable, WIN* status, SIM* sim)
+{
+    RENDERER* renderer = (RENDERER*)malloc(sizeof(RENDERER));
+    memset(renderer, 0, sizeof(RENDERER));
+    renderer->playable = playable;
+    renderer->status = status;
+    CAR_POOL* cars = sim->cars;
+    renderer->maxDirty = 2 * (cars->count + 2);     // at most two regions per object
+    renderer->dirty = (RECT*)malloc(renderer->maxDirty * sizeof(RECT));
+    renderer->carX = (int*)malloc((cars->count + 1) * sizeof(int));
+    renderer->laneRows = (char*)calloc(sim->rows, sizeof(char));
+    for (int i = 0; i < cars->count; i++)
+    {
+        if (cars->y[i] + cars->height < sim->rows)
+        {
+            renderer->laneRows[cars->y[i] + cars->height] = 1;
+        }
+    }
+    renderer->frogX = sim->frog->x;
+    renderer->frogY = sim->frog->y;
+    renderer->destX = sim->dest->x;
+    renderer->destY = sim->dest->y;
+    renderer->scrolled = cars->base;
+    renderer->ioFd = open("/proc/self/io", O_RDONLY);
+    renderer->timeDecimals = 2;
+
+    UpdateCamera(renderer, sim);
+    DamageView(renderer, sim);  // whole first frame
+    DrawDamaged(renderer, sim);
+    return renderer;
+}
+
+void RenderFrame(RENDERER* renderer, SIM* sim)
+{
+    renderer->nDirty = 0;
+    int scrolled = sim->cars->base != renderer->scrolled;  // the endless road has moved under the camera
+    renderer->scrolled = sim->cars->base;
+    if (UpdateCamera(renderer, sim) || scrolled)
+    {
+        DamageView(renderer, sim);
+    }
+    else
+    {
+        CAR_POOL* cars = sim->cars;
+        for (int i = renderer->carFrom; i < renderer->carTo; i++)
+        {
+            AddMoved(renderer, cars->x[i], cars->y[i], renderer->carX[i], cars->y[i], cars->width, cars->height);
+            renderer->carX[i] = cars->x[i];
+        }
+    }
+    OBJ* frog = sim->frog;
+    AddMoved(renderer, frog->x, frog->y, renderer->frogX, renderer->frogY, frog->width, frog->height);
+    renderer->frogX = sim->frog->x;
+    renderer->frogY = sim->frog->y;
+    for (int i = 0; i < renderer->nOthers; i++)
+    {
+        OBJ* other = &renderer->others[i];
+        AddMoved(renderer, other->x, other->y, renderer->otherX[i], renderer->otherY[i], frog->width, frog->height);
+        renderer->otherX[i] = other->x;
+        renderer->otherY[i] = other->y;
+    }
+    DEST* dest = sim->dest;
+    AddMoved(renderer, dest->x, dest->y, renderer->destX, renderer->destY, dest->width, dest->height);  // next checkpoint
+    renderer->destX = dest->x;
+    renderer->destY = dest->y;
+    DrawDamaged(renderer, sim);
+}
+
+int StepsToChange(RENDERER* renderer, SIM* sim, int maxSteps)
+{
+    CAR_POOL* cars = sim->cars;
+    int right = cars->xmax - cars->width;
+    int steps = maxSteps;
+    SyncCars(cars, renderer->carFrom, renderer->carTo);
+    for (int i = renderer->carFrom; i < renderer->carTo && right >= cars->xmin && steps > 1; i++)
+    {
+        int m = cars->moveFactor[i];
+        int atWall = (cars->direction[i] == 1 && cars->x[i] == right) || (cars->direction[i] == 0 && cars->x[i] == cars->xmin);
+        int moves = atWall && cars->disappearing[i] ? 1 : (m - cars->phase[i]) % m + 1;  // replaced in the next step, or moves in its next phase 0
+        steps = moves < steps ? moves : steps;
+    }
+    TIMER* timer = sim->timer;
+    int initialTime = sim->cfg->timing->initialTime + sim->checkpoints * CHECKPOINT_TIME;
+    char text[64];
+    for (int k = 1; k < steps; k++)
+    {
+        double timeLeft = TimeLeftAt(timer, initialTime, timer->frameNo + k);  // as UpdateTimer will have it
+        if (timeLeft < timer->frameTime / 1000.0)
+        {
+            return k;   // time over
+        }
+        snprintf(text, sizeof(text), "Time: %.*f", renderer->timeDecimals, timeLeft);
+        if (strcmp(text, renderer->timeText) != 0)
+        {
+            return k;
+        }
+    }
+    return steps;
+}
+
+void SetOtherFrogs(RENDERER* renderer, OBJ* frogs, int count)
+{
+    renderer->maxDirty += 2 * (count - renderer->nOthers);
+    renderer->dirty = (RECT*)realloc(renderer->dirty, renderer->maxDirty * sizeof(RECT));
+    renderer->others = frogs;
+    renderer->nOthers = count;
+    renderer->otherX = (int*)realloc(renderer->otherX, (count + 1) * sizeof(int));
+    renderer->otherY = (int*)realloc(renderer->otherY, (count + 1) * sizeof(int));
+    for (int i = 0; i < count; i++)
+    {
+        renderer->otherX[i] = frogs[i].x;
+        renderer->otherY[i] = frogs[i].y;
+    }
+}
+
+void PrintRenderStats(RENDERER* renderer, FILE* out)
+{
+    RENDER_STATS* stats = &renderer->stats;
+    if ((renderer->ioFd < 0 && !renderer->playable->ansi) || stats->frames == 0)
+    {
+        return;
+    }
+    fprintf(out, "backend: %s\n", renderer->playable->ansi ? "ansi" : "ncurses");
+    fprintf(out, "frames: %ld\n", stats->frames);
+    fprintf(out, "bytes/frame: %.1f (max %ld)\n", (double)stats->bytes / stats->frames, stats->maxBytes);
+    fprintf(out, "writes/frame: %.2f\n", (double)stats->syscalls / stats->frames);
+}
+
+void FreeRenderer(RENDERER* renderer)
+{
+    if (renderer->ioFd >= 0)
+    {
+        close(renderer->ioFd);
+    }
+    free(renderer->dirty);
+    free(renderer->carX);
+    free(renderer->otherX);
+    free(renderer->otherY);
+    free(renderer->laneRows);
+    free(renderer);
+}
@@ -0,0 +1,107 @@
+// render.h
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+#include "sim.h"
+#include "ansi.h"
+
+// --- DATA STRUCTURES ---
+typedef enum {
+    COLOR_MAIN,
+    COLOR_STATUS,
+    COLOR_PLAYABLE,
+    COLOR_FROG,
+    COLOR_CAR,
+    COLOR_DEST
+} Color;
+
+// Window structure
+typedef struct {
+    WINDOW* window; // extends ncurses window
+    Color color;
+    int x, y;       // top-left corner coordinates
+    int rows, cols;
+    ANSI_TERM* ansi;    // draws into the ANSI back end instead of ncurses when set
+} WIN;
+
+// Damaged region of the playable window
+typedef struct {
+    int x, y;       // top-left corner coordinates
+    int width, height;
+} RECT;
+
+// Output of the process so far, read from /proc/self/io
+typedef struct {
+    long bytes;
+    long syscalls;
+} IO_COUNT;
+
+// Terminal output statistics - /proc/self/io for ncurses, counted by the ANSI back end itself
+typedef struct {
+    long frames;
+    long bytes;         // in total
+    long syscalls;
+    long lastBytes;     // written by the last frame
+    long maxBytes;
+} RENDER_STATS;
+
+// Renderer - collects the damage of a frame and sends it to the terminal in one pass
+// The playable window is a camera over the world: it shows world rows [viewY, viewY + rows) and follows the frog,
+// only the cars of the lanes overlapping it are drawn (and simulated every frame)
+typedef struct {
+    WIN* playable;
+    WIN* status;
+    RECT* dirty;        // damaged regions of the current frame, in world coordinates
+    int nDirty;
+    int maxDirty;
+    char* laneRows;     // 1 for the world rows with a lane line
+    int viewY;          // top world row of the playable window
+    int carFrom, carTo; // cars in the lanes overlapping the window
+    int scrolled;       // lanes the endless road had scrolled by in the previous frame
+    int frogX, frogY;   // positions drawn in the previous frame
+    int destX, destY;
+    int* carX;
+    OBJ* others;        // frogs of the other players (network client), NULL if none
+    int nOthers;
+    int* otherX;        // their positions drawn in the previous frame
+    int* otherY;
+    int timeDecimals;   // of the time in the status window
+    char timeText[32];  // status fields on the screen
+    char positionText[64];
+    int ioFd;           // /proc/self/io, -1 if not available
+    RENDER_STATS stats;
+} RENDERER;
+
+
+// --- RENDER FUNCTIONS ---
+// Color pairs of the game - after initscr or newterm, and for the ANSI back end
+void InitColors();
+void InitAnsiColors(ANSI_TERM* term);
+
+// Drawing in window coordinates, through ncurses or the ANSI back end of the window
+void DrawText(WIN* win, int y, int x, const char* text, int length, Color color);
+void DrawHLine(WIN* win, int y, int x, char glyph, int length, Color color);
+// Border of the window, in its own color
+void DrawBox(WIN* win);
+// Formatted text in the window's color
+void PrintWin(WIN* win, int y, int x, const char* format, ...);
+// Show what has been drawn into the window
+void RefreshWin(WIN* win);
+
+void CleanWin(WIN* win);
+void PrintSprite(WIN* win, SPRITE* sprite, int x, int y, Color color);
+
+// Renderer initializer - draws the whole first frame
+RENDERER* InitRenderer(WIN* playable, WIN* status, SIM* sim);
+// Collect the damage of the last simulation step, repaint it and flush the terminal once
+void RenderFrame(RENDERER* renderer, SIM* sim);
+// Steps until the frame on the screen changes by itself (a car on it moves or is replaced, the time shown changes
+// or runs out), at most maxSteps - the frog only moves on keys
+int StepsToChange(RENDERER* renderer, SIM* sim, int maxSteps);
+// Also draw count frogs of other players, below the game's own frog - they are read every frame
+void SetOtherFrogs(RENDERER* renderer, OBJ* frogs, int count);
+void PrintRenderStats(RENDERER* renderer, FILE* out);
+void FreeRenderer(RENDERER* renderer);
+
+#endif // RENDER_H
@@ -0,0 +1,297 @@
+// replay.c
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "replay.h"
+
+#define KEYFRAME_ALIGN 8
+
+
+// --- RECORDING FUNCTIONS ---
+RECORDING* InitRecording(SIM* sim)
+{
+    RECORDING* recording = (RECORDING*)malloc(sizeof(RECORDING));
+    memset(recording, 0, sizeof(RECORDING));
+    memcpy(recording->header.magic, RECORDING_MAGIC, 4);
+    recording->header.version = RECORDING_VERSION;
+    recording->header.seed = sim->seed;
+    recording->header.cfgHash = HashCfg(sim->cfg);
+    recording->header.result = RUNNING;
+    recording->header.keyframeInterval = KEYFRAME_INTERVAL;
+    recording->header.keyframeSize = sizeof(KEYFRAME) + SimStateSize(sim);
+    recording->capacity = 4096;     // a full 20 s game needs much less
+    recording->data = (unsigned char*)malloc(recording->capacity);
+    recording->keyframesCapacity = 16 * recording->header.keyframeSize;
+    recording->keyframes = (unsigned char*)malloc(recording->keyframesCapacity);
+    recording->lastFrame = 0;
+    return recording;
+}
+
+void WriteByte(RECORDING* recording, unsigned char byte)
+{
+    if (recording->header.size == recording->capacity)
+    {
+        recording->capacity *= 2;
+        recording->data = (unsigned char*)realloc(recording->data, recording->capacity);
+    }
+    recording->data[recording->header.size++] = byte;
+}
+
+void RecordInput(RECORDING* recording, int frame, int key)
+{
+    unsigned int delta = frame - recording->lastFrame;
+    while (delta >= 0x80)   // varint, 7 bits per byte
+    {
+        WriteByte(recording, (unsigned char)(delta | 0x80));
+        delta >>= 7;
+    }
+    WriteByte(recording, (unsigned char)delta);
+    WriteByte(recording, key >= 0 && key < OTHER_KEY ? (unsigned char)key : OTHER_KEY);
+    recording->lastFrame = frame;
+    recording->header.nInputs++;
+}
+
+void RecordKeyframe(RECORDING* recording, SIM* sim)
+{
+    size_t size = recording->header.keyframeSize;
+    size_t used = recording->header.nKeyframes * size;
+    if (used + size > recording->keyframesCapacity)
+    {
+        recording->keyframesCapacity *= 2;
+        recording->keyframes = (unsigned char*)realloc(recording->keyframes, recording->keyframesCapacity);
+    }
+    KEYFRAME* keyframe = (KEYFRAME*)(recording->keyframes + used);
+    keyframe->inputPosition = recording->header.size;
+    keyframe->inputFrame = recording->lastFrame;
+    SaveSimState(sim, keyframe + 1);
+    recording->header.nKeyframes++;
+}
+
+GameResult StepRecorded(SIM* sim, RECORDING* recording, int key)
+{
+    int frame = sim->timer->frameNo;
+    if ((frame - 1) % KEYFRAME_INTERVAL == 0)
+    {
+        RecordKeyframe(recording, sim);
+    }
+    GameResult result = StepSim(sim, key);
+    if (sim->input != NO_KEY)
+    {
+        RecordInput(recording, frame, sim->input);
+    }
+    return result;
+}
+
+void FinishRecording(RECORDING* recording, SIM* sim)
+{
+    recording->header.frames = sim->timer->frameNo;
+    recording->header.result = sim->result;
+    recording->header.stateHash = SimStateHash(sim);
+}
+
+int SaveRecording(RECORDING* recording, const char* filename)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+    {
+        return -1;
+    }
+    static const char padding[KEYFRAME_ALIGN] = { 0 };
+    size_t end = sizeof(RECORDING_HEADER) + recording->header.size;
+    size_t pad = (KEYFRAME_ALIGN - end % KEYFRAME_ALIGN) % KEYFRAME_ALIGN;
+    size_t keyframes = recording->header.nKeyframes * recording->header.keyframeSize;
+    int ok = fwrite(&recording->header, sizeof(RECORDING_HEADER), 1, file) == 1 &&
+        fwrite(recording->data, 1, recording->header.size, file) == recording->header.size &&
+        fwrite(padding, 1, pad, file) == pad &&
+        fwrite(recording->keyframes, 1, keyframes, file) == keyframes;
+    return (fclose(file) == 0 && ok) ? 0 : -1;
+}
+
+void FreeRecording(RECORDING* recording)
+{
+    free(recording->data);
+    free(recording->keyframes);
+    free(recording);
+}
+
+
+// --- REPLAY FUNCTIONS ---
+REPLAY* OpenReplay(const char* filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(RECORDING_HEADER))
+    {
+        close(fd);
+        return NULL;
+    }
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping stays valid
+    if (map == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const RECORDING_HEADER* header = (const RECORDING_HEADER*)map;
+    size_t keyframesOffset = (sizeof(RECORDING_HEADER) + header->size + KEYFRAME_ALIGN - 1) / KEYFRAME_ALIGN * KEYFRAME_ALIGN;
+    if (memcmp(header->magic, RECORDING_MAGIC, 4) != 0 || header->version != RECORDING_VERSION ||
+        header->keyframeInterval == 0 || header->nKeyframes == 0 || keyframesOffset + (size_t)header->nKeyframes * header->keyframeSize > (size_t)info.st_size)
+    {
+        munmap(map, info.st_size);
+        return NULL;
+    }
+
+    REPLAY* replay = (REPLAY*)malloc(sizeof(REPLAY));
+    memset(replay, 0, sizeof(REPLAY));
+    replay->map = map;
+    replay->mapSize = info.st_size;
+    replay->header = header;
+    replay->inputs = (const unsigned char*)map + sizeof(RECORDING_HEADER);
+    replay->keyframes = (const unsigned char*)map + keyframesOffset;
+    return replay;
+}
+
+void CloseReplay(REPLAY* replay)
+{
+    munmap(replay->map, replay->mapSize);
+    free(replay);
+}
+
+// Read the next input into nextFrame/nextKey
+void ReadInput(REPLAY* replay)
+{
+    unsigned int delta = 0;
+    int shift = 0;
+    replay->pending = 0;
+    while (replay->position < replay->header->size)
+    {
+        unsigned char byte = replay->inputs[replay->position++];
+        delta |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+        if (!(byte & 0x80))
+        {
+            if (replay->position >= replay->header->size)
+            {
+                return; // truncated
+            }
+            replay->nextKey = replay->inputs[replay->position++];
+            replay->lastFrame += delta;
+            replay->nextFrame = replay->lastFrame;
+            replay->pending = 1;
+            return;
+        }
+    }
+}
+
+const KEYFRAME* GetKeyframe(REPLAY* replay, int i)
+{
+    return (const KEYFRAME*)(replay->keyframes + (size_t)i * replay->header->keyframeSize);
+}
+
+void LoadKeyframe(REPLAY* replay, SIM* sim, int i)
+{
+    const KEYFRAME* keyframe = GetKeyframe(replay, i);
+    LoadSimState(sim, keyframe + 1);
+    replay->position = keyframe->inputPosition;
+    replay->lastFrame = keyframe->inputFrame;
+    ReadInput(replay);
+}
+
+SIM* InitReplaySim(REPLAY* replay, CFG* cfg, SPRITE_ATLAS* sprites, ARENA* arena)
+{
+    SIM* sim = InitSim(cfg, sprites, replay->header->seed, arena);
+    if (replay->header->keyframeSize != sizeof(KEYFRAME) + SimStateSize(sim))
+    {
+        return NULL;
+    }
+    for (int i = 0; i < (int)replay->header->nKeyframes; i++)
+    {
+        int32_t nCars;
+        memcpy(&nCars, (const unsigned char*)(GetKeyframe(replay, i) + 1) + offsetof(SIM_STATE, nCars), sizeof(nCars));   // keyframes are not aligned to SIM_STATE, as in LoadSimState
+        if (nCars != sim->cars->count)
+        {
+            return NULL;    // the car arrays would not be those of the game
+        }
+    }
+    LoadKeyframe(replay, sim, 0);
+    return sim;
+}
+
+GameResult StepReplay(REPLAY* replay, SIM* sim)
+{
+    int input = replay->pending && replay->nextFrame == sim->timer->frameNo ? replay->nextKey : NO_KEY;
+    GameResult result = StepSim(sim, input);
+    if (input != NO_KEY)
+    {
+        ReadInput(replay);
+    }
+    return result;
+}
+
+void SeekReplay(REPLAY* replay, SIM* sim, int frame)
+{
+    int i = (frame - 1) / (int)replay->header->keyframeInterval;
+    i = i < 0 ? 0 : (i >= (int)replay->header->nKeyframes ? (int)replay->header->nKeyframes - 1 : i);
+    int keyframeFrame = 1 + i * (int)replay->header->keyframeInterval;
+    if (sim->timer->frameNo > frame || sim->timer->frameNo < keyframeFrame || sim->result != RUNNING)
+    {
+        LoadKeyframe(replay, sim, i);   // going back or past the next keyframe - continue from the keyframe
+    }
+    while (sim->timer->frameNo < frame && sim->result == RUNNING)
+    {
+        StepReplay(replay, sim);
+    }
+}
+
+int VerifyReplay(REPLAY* replay, CFG* cfg, SPRITE_ATLAS* sprites, FILE* out)
+{
+    if (replay->header->cfgHash != HashCfg(cfg))
+    {
+        fprintf(out, "replay: recorded with a different config\n");
+        return 0;
+    }
+    ARENA* arena = InitArena(SimArenaSize(cfg));
+    SIM* sim = InitReplaySim(replay, cfg, sprites, arena);
+    if (!sim)
+    {
+        fprintf(out, "replay: the keyframes do not fit the game of the config\n");
+        FreeArena(arena);
+        return 0;
+    }
+    size_t stateSize = SimStateSize(sim);
+    void* state = ArenaAlloc(arena, stateSize);
+
+    int diverged = 0;
+    int keyframe = 0;
+    while (sim->result == RUNNING)
+    {
+        int frame = sim->timer->frameNo;
+        if ((frame - 1) % (int)replay->header->keyframeInterval == 0 && keyframe < (int)replay->header->nKeyframes)
+        {
+            SaveSimState(sim, state);
+            diverged |= memcmp(state, GetKeyframe(replay, keyframe++) + 1, stateSize) != 0;
+        }
+        int expected = replay->pending && replay->nextFrame == frame;
+        StepReplay(replay, sim);
+        diverged |= expected && sim->input == NO_KEY;   // the key must be accepted again
+    }
+
+    int ok = !diverged && !replay->pending && keyframe == (int)replay->header->nKeyframes &&
+        sim->timer->frameNo == replay->header->frames &&
+        (int)sim->result == replay->header->result &&
+        SimStateHash(sim) == replay->header->stateHash;
+    fprintf(out, "replay: %s - %u inputs, %u keyframes, %d frames, result %d (recorded %d frames, result %d)\n",
+        ok ? "OK" : "MISMATCH", replay->header->nInputs, replay->header->nKeyframes, sim->timer->frameNo, sim->result,
+        replay->header->frames, replay->header->result);
+    FreeArena(arena);
+    return ok;
+}
@@ -0,0 +1,84 @@
+// replay.h
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "sim.h"
+
+#define RECORDING_MAGIC "FRG1"
+#define RECORDING_VERSION 5
+#define OTHER_KEY 0xFF          // recorded for accepted keys that do not fit in a byte - they only start the cooldown
+#define KEYFRAME_INTERVAL 64    // frames between full state keyframes
+
+// Recording file header
+// Followed by the inputs - frames since the previous input (varint) and the key byte,
+// then (aligned to 8 bytes) one keyframe every keyframeInterval frames, starting with frame 1
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+    uint64_t cfgHash;
+    uint64_t stateHash;         // SimStateHash at the end of the game
+    int32_t frames;             // frame number at the end of the game
+    int32_t result;             // GameResult
+    uint32_t nInputs;
+    uint32_t size;              // bytes of input data
+    uint32_t keyframeInterval;
+    uint32_t nKeyframes;
+    uint32_t keyframeSize;      // bytes per keyframe, KEYFRAME included
+    uint32_t reserved;
+} RECORDING_HEADER;
+
+// Keyframe - where the input stream stands at the keyframe, followed by the SIM_STATE
+typedef struct {
+    uint32_t inputPosition;     // offset of the next input
+    int32_t inputFrame;         // frame of the last input before it
+} KEYFRAME;
+
+// Recording - inputs accepted by the simulation and periodic keyframes, written while playing
+typedef struct {
+    RECORDING_HEADER header;
+    unsigned char* data;        // inputs
+    size_t capacity;
+    unsigned char* keyframes;
+    size_t keyframesCapacity;
+    int lastFrame;              // frame of the last input written
+} RECORDING;
+
+// Replay - a memory-mapped recording
+typedef struct {
+    void* map;
+    size_t mapSize;
+    const RECORDING_HEADER* header;
+    const unsigned char* inputs;
+    const unsigned char* keyframes;
+    size_t position;            // reading position in inputs
+    int lastFrame;              // frame of the last input read
+    int pending;                // 1 if nextFrame/nextKey hold an input not played yet
+    int nextFrame;
+    int nextKey;
+} REPLAY;
+
+// --- RECORDING FUNCTIONS ---
+RECORDING* InitRecording(SIM* sim);
+// StepSim that records the accepted input and the keyframes
+GameResult StepRecorded(SIM* sim, RECORDING* recording, int key);
+// Store the final state of the game in the header
+void FinishRecording(RECORDING* recording, SIM* sim);
+// 0 on success, -1 on error
+int SaveRecording(RECORDING* recording, const char* filename);
+void FreeRecording(RECORDING* recording);
+
+// --- REPLAY FUNCTIONS ---
+// NULL if the file cannot be mapped or is not a recording
+REPLAY* OpenReplay(const char* filename);
+void CloseReplay(REPLAY* replay);
+// New game in the recorded initial state - NULL if the keyframes do not hold the state of this game (the arena is the caller's)
+SIM* InitReplaySim(REPLAY* replay, CFG* cfg, SPRITE_ATLAS* sprites, ARENA* arena);
+// Step the game one frame with the recorded input
+GameResult StepReplay(REPLAY* replay, SIM* sim);
+// Bring the game to the start of the given frame - restores the nearest keyframe and simulates at most KEYFRAME_INTERVAL frames
+void SeekReplay(REPLAY* replay, SIM* sim, int frame);
+// Replay at full speed without a terminal - returns 1 if every keyframe and the end of the game match the recording
+int VerifyReplay(REPLAY* replay, CFG* cfg, SPRITE_ATLAS* sprites, FILE* out);
+
+#endif // REPLAY_H
@@ -0,0 +1,237 @@
+// rewind.c
+#include <stdlib.h>
+#include <string.h>
+#include "rewind.h"
+
+#define REWIND_HEADER_WORDS ((int)(sizeof(SIM_STATE) / sizeof(uint32_t)))
+
+
+// --- PACKED STATES ---
+// Pack the state of the game - SaveSimState, with the car arrays rearranged to change as little as possible per frame
+void PackState(REWIND* rewind, SIM* sim, uint32_t* words)
+{
+    SaveSimState(sim, rewind->state);
+    const SIM_STATE* state = (const SIM_STATE*)rewind->state;
+    int n = state->nCars;
+    const int32_t* x = (const int32_t*)(state + 1);
+    const int32_t* direction = x + n;
+    const int32_t* phase = x + 2 * n;
+    const int32_t* disappearing = x + 3 * n;
+    const int32_t* spawns = x + 4 * n;
+    memcpy(words, state, sizeof(SIM_STATE));
+    uint32_t* cars = words + REWIND_HEADER_WORDS;
+    for (int i = 0; i < n; i++)
+    {
+        int m = sim->cars->moveFactor[i];
+        cars[i] = (uint32_t)x[i];
+        cars[n + i] = (uint32_t)(direction[i] | disappearing[i] << 1);
+        cars[2 * n + i] = (uint32_t)((phase[i] - state->frameNo % m + m) % m);
+        cars[3 * n + i] = (uint32_t)spawns[i];
+    }
+}
+
+// Put the game into a packed state - the speeds of the cars are those of its config (and lanes, on the endless road)
+void UnpackState(REWIND* rewind, SIM* sim, const uint32_t* words)
+{
+    SIM_STATE* state = (SIM_STATE*)rewind->state;
+    memcpy(state, words, sizeof(SIM_STATE));
+    int n = state->nCars;
+    int moveFactor = sim->cfg->cars->moveFactor;
+    int32_t* x = (int32_t*)(state + 1);
+    const uint32_t* cars = words + REWIND_HEADER_WORDS;
+    for (int i = 0; i < n; i++)
+    {
+        int m = sim->cfg->area->endless ? LaneMoveFactor(sim->cars, state->scrolled + n - 1 - i, moveFactor) : moveFactor;
+        x[i] = (int32_t)cars[i];
+        x[n + i] = (int32_t)(cars[n + i] & 1);
+        x[2 * n + i] = (int32_t)((cars[2 * n + i] + state->frameNo % m) % m);
+        x[3 * n + i] = (int32_t)(cars[n + i] >> 1);
+        x[4 * n + i] = (int32_t)cars[3 * n + i];
+    }
+    LoadSimState(sim, state);
+}
+
+
+// --- DELTAS ---
+unsigned char* PutVarint(unsigned char* out, uint32_t value)
+{
+    while (value >= 0x80)   // 7 bits per byte
+    {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+const unsigned char* GetVarint(const unsigned char* in, uint32_t* value)
+{
+    *value = 0;
+    for (int shift = 0; ; shift += 7)
+    {
+        unsigned char byte = *in++;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (byte < 0x80)
+        {
+            return in;
+        }
+    }
+}
+
+// Encode current ^ next into the scratch buffer - its length
+size_t EncodeDelta(REWIND* rewind)
+{
+    unsigned char* out = rewind->scratch;
+    int last = -1;
+    for (int i = 0; i < rewind->words; i++)
+    {
+        uint32_t changed = rewind->current[i] ^ rewind->next[i];
+        if (changed)
+        {
+            out = PutVarint(out, (uint32_t)(i - last - 1));
+            out = PutVarint(out, changed);
+            last = i;
+        }
+    }
+    return (size_t)(out - rewind->scratch);
+}
+
+// XOR an encoded delta into the current state
+void ApplyDelta(REWIND* rewind, const unsigned char* in, size_t length)
+{
+    const unsigned char* end = in + length;
+    int i = -1;
+    while (in < end)
+    {
+        uint32_t gap, changed;
+        in = GetVarint(in, &gap);
+        in = GetVarint(in, &changed);
+        i += (int)gap + 1;
+        rewind->current[i] ^= changed;
+    }
+}
+
+void DropOldest(REWIND* rewind)
+{
+    rewind->first = (rewind->first + 1) % rewind->maxDeltas;
+    rewind->count--;
+}
+
+// Deltas lie in the byte ring in the order they were pushed, from the oldest (the first one at or after head) on
+int Overlaps(REWIND_DELTA* delta, size_t offset, size_t length)
+{
+    return delta->offset < offset + length && offset < delta->offset + delta->length;
+}
+
+
+// --- REWIND FUNCTIONS ---
+REWIND* InitRewind(SIM* sim, int frames)
+{
+    REWIND* rewind = (REWIND*)malloc(sizeof(REWIND));
+    rewind->words = REWIND_HEADER_WORDS + 4 * sim->cars->count;
+    rewind->current = (uint32_t*)malloc(rewind->words * sizeof(uint32_t));
+    rewind->next = (uint32_t*)malloc(rewind->words * sizeof(uint32_t));
+    rewind->scratch = (unsigned char*)malloc(rewind->words * 10);
+    rewind->state = malloc(SimStateSize(sim));
+    rewind->maxDeltas = frames > 1 ? frames : 1;
+    rewind->capacity = (size_t)rewind->maxDeltas * (sizeof(SIM_STATE) + REWIND_BYTES_PER_CAR * sim->cars->count);
+    rewind->bytes = (unsigned char*)malloc(rewind->capacity);
+    rewind->deltas = (REWIND_DELTA*)malloc(rewind->maxDeltas * sizeof(REWIND_DELTA));
+    rewind->pushed = 0;
+    rewind->rewound = 0;
+    rewind->dropped = 0;
+    ResetRewind(rewind, sim);
+    return rewind;
+}
+
+void ResetRewind(REWIND* rewind, SIM* sim)
+{
+    rewind->first = 0;
+    rewind->count = 0;
+    rewind->head = 0;
+    PackState(rewind, sim, rewind->current);
+}
+
+void PushRewind(REWIND* rewind, SIM* sim)
+{
+    PackState(rewind, sim, rewind->next);
+    size_t length = EncodeDelta(rewind);
+    if (length > rewind->capacity)
+    {
+        rewind->dropped += rewind->count;   // a frame larger than the whole ring - the history starts again
+        rewind->count = 0;
+        rewind->head = 0;
+    }
+    else
+    {
+        if (rewind->head + length > rewind->capacity)
+        {
+            while (rewind->count > 0 && rewind->deltas[rewind->first].offset >= rewind->head)
+            {
+                DropOldest(rewind);     // the tail of the ring is skipped - the oldest deltas are there
+                rewind->dropped++;
+            }
+            rewind->head = 0;
+        }
+        while (rewind->count > 0 &&
+            (rewind->count == rewind->maxDeltas || Overlaps(&rewind->deltas[rewind->first], rewind->head, length)))
+        {
+            rewind->dropped += rewind->count < rewind->maxDeltas;
+            DropOldest(rewind);
+        }
+        REWIND_DELTA* delta = &rewind->deltas[(rewind->first + rewind->count) % rewind->maxDeltas];
+        delta->offset = (uint32_t)rewind->head;
+        delta->length = (uint32_t)length;
+        memcpy(rewind->bytes + rewind->head, rewind->scratch, length);
+        rewind->head += length;
+        rewind->count++;
+    }
+    uint32_t* swap = rewind->current;
+    rewind->current = rewind->next;
+    rewind->next = swap;
+    rewind->pushed++;
+}
+
+int StepBack(REWIND* rewind, SIM* sim)
+{
+    if (rewind->count == 0)
+    {
+        return 0;
+    }
+    REWIND_DELTA* delta = &rewind->deltas[(rewind->first + rewind->count - 1) % rewind->maxDeltas];
+    ApplyDelta(rewind, rewind->bytes + delta->offset, delta->length);
+    rewind->head = delta->offset;   // the newest delta is the last one written
+    rewind->count--;
+    rewind->rewound++;
+    UnpackState(rewind, sim, rewind->current);
+    return 1;
+}
+
+size_t RewindBytes(REWIND* rewind)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < rewind->count; i++)
+    {
+        bytes += rewind->deltas[(rewind->first + i) % rewind->maxDeltas].length;
+    }
+    return bytes;
+}
+
+void PrintRewindStats(REWIND* rewind, FILE* out)
+{
+    size_t bytes = RewindBytes(rewind);
+    fprintf(out, "rewind: %ld frames recorded, %ld stepped back, %ld dropped early\n", rewind->pushed, rewind->rewound, rewind->dropped);
+    fprintf(out, "rewind history: %d frames in %zu bytes (%.1f per frame, ring of %zu)\n", rewind->count, bytes,
+        rewind->count > 0 ? (double)bytes / rewind->count : 0.0, rewind->capacity);
+}
+
+void FreeRewind(REWIND* rewind)
+{
+    free(rewind->current);
+    free(rewind->next);
+    free(rewind->scratch);
+    free(rewind->state);
+    free(rewind->bytes);
+    free(rewind->deltas);
+    free(rewind);
+}
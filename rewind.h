@@ -0,0 +1,54 @@
+// rewind.h
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdio.h>
+#include "sim.h"
+
+#define REWIND_KEY 'r'          // held down, plays the game backwards
+#define REWIND_HOLD_MS 250      // a press rewinds this long, the key repeat of a held key keeps it going
+#define REWIND_BYTES_PER_CAR 2  // budget of the history per car and frame - a moving car costs about that much
+
+// Delta of a frame in the history ring
+typedef struct {
+    uint32_t offset;        // in the byte ring
+    uint32_t length;
+} REWIND_DELTA;
+
+// Rewind history - every step of the game packs its state into words (the SIM_STATE header, then car x,
+// direction | disappearing << 1, phase - frame (mod moveFactor, constant while a car drives) and spawns), XORs
+// it with the packed state of the step before and keeps the nonzero words as varint (gap, xor) pairs in a
+// preallocated byte ring. Only the newest state is kept whole: a step back XORs the newest delta into it and
+// loads it into the game - no allocation and no simulation. The oldest deltas are dropped as the ring fills up
+typedef struct {
+    int words;              // of a packed state
+    uint32_t* current;      // packed state of the newest frame
+    uint32_t* next;         // being packed
+    unsigned char* scratch; // delta being encoded - at most 10 bytes per word
+    void* state;            // SIM_STATE for LoadSimState
+    unsigned char* bytes;   // ring of encoded deltas
+    size_t capacity;
+    size_t head;            // where the next delta goes
+    REWIND_DELTA* deltas;   // ring - delta k turns the state of a frame into that of the frame before
+    int maxDeltas;
+    int first, count;       // oldest delta, deltas held
+    long pushed;            // frames recorded
+    long rewound;           // frames stepped back
+    long dropped;           // deltas dropped before their time for lack of bytes
+} REWIND;
+
+// --- REWIND FUNCTIONS ---
+// History of up to the given number of frames of a game, starting with its current state
+REWIND* InitRewind(SIM* sim, int frames);
+// Forget the history - the current state of the game becomes the oldest one (after a change of its config)
+void ResetRewind(REWIND* rewind, SIM* sim);
+// Record the state the game has just stepped into
+void PushRewind(REWIND* rewind, SIM* sim);
+// Put the game back into the frame before the newest recorded one - 0 if the history is exhausted
+int StepBack(REWIND* rewind, SIM* sim);
+// Bytes of history held
+size_t RewindBytes(REWIND* rewind);
+void PrintRewindStats(REWIND* rewind, FILE* out);
+void FreeRewind(REWIND* rewind);
+
+#endif // REWIND_H
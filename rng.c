@@ -0,0 +1,36 @@
+// rng.c
+#include "rng.h"
+
+
+// --- RNG FUNCTIONS ---
+void SeedRng(RNG* rng, uint64_t seed)
+{
+    rng->state = 0;
+    rng->inc = (seed << 1) | 1;
+    NextRng(rng);
+    rng->state += seed;
+    NextRng(rng);
+}
+
+uint32_t NextRng(RNG* rng)
+{
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+int RandInt(RNG* rng, int min, int max)
+{
+    uint64_t range = (uint64_t)(max - min) + 1;
+    return min + (int)(((uint64_t)NextRng(rng) * range) >> 32);   // multiply-shift instead of modulo
+}
+
+uint64_t DeriveSeed(uint64_t seed, uint64_t i)
+{
+    uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,21 @@
+// rng.h
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Random number generator - PCG32, one per game session so that a seed reproduces the whole game
+typedef struct {
+    uint64_t state;
+    uint64_t inc;       // stream selector, always odd
+} RNG;
+
+// --- RNG FUNCTIONS ---
+void SeedRng(RNG* rng, uint64_t seed);
+uint32_t NextRng(RNG* rng);
+// Random number (inclusive)
+int RandInt(RNG* rng, int min, int max);
+// Seed for the i-th game of a series (SplitMix64 of the base seed)
+uint64_t DeriveSeed(uint64_t seed, uint64_t i);
+
+#endif // RNG_H
@@ -0,0 +1,570 @@
+// server.c
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "pacer.h"
+
+#define LISTENER UINT64_MAX     // epoll data of the listening socket
+
+volatile sig_atomic_t serverStop = 0;
+
+
+// --- ROUND FUNCTIONS ---
+void StopServer(int signal)
+{
+    (void)signal;
+    serverStop = 1;
+}
+
+// Put the frog of a player at the start of the road
+void SpawnFrog(SERVER* server, CLIENT* client)
+{
+    client->frog = *server->sim->frog;
+    client->alive = 1;
+    client->nKeys = 0;
+}
+
+// New game for every player - the whole road is simulated every step, the clients show all of it
+void StartRound(SERVER* server)
+{
+    ResetArena(server->arena);
+    server->sim = InitSim(server->cfg, server->sprites, DeriveSeed(server->seed, server->round++), server->arena);
+    server->sim->viewY = 0;
+    server->sim->viewRows = server->sim->rows;
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        if (server->clients[i].fd >= 0 && server->clients[i].role == 0)
+        {
+            SpawnFrog(server, &server->clients[i]);
+        }
+    }
+}
+
+
+// --- CLIENT FUNCTIONS ---
+void WatchClient(SERVER* server, int slot, uint32_t events)
+{
+    CLIENT* client = &server->clients[slot];
+    struct epoll_event event;
+    event.events = events;
+    event.data.u64 = (uint64_t)client->generation << 32 | (uint32_t)slot;
+    epoll_ctl(server->epollFd, EPOLL_CTL_MOD, client->fd, &event);
+}
+
+void CloseClient(SERVER* server, int slot)
+{
+    CLIENT* client = &server->clients[slot];
+    close(client->fd);  // also takes it out of epoll
+    client->fd = -1;
+    client->role = -1;
+    client->alive = 0;  // the next tick tells the others the frog is gone
+    FreeBuffer(&client->in);
+    FreeBuffer(&client->out);
+    server->nClients--;
+}
+
+// Send as much of the queue as the socket takes - 0 if the client is still connected
+int FlushClient(SERVER* server, int slot)
+{
+    CLIENT* client = &server->clients[slot];
+    size_t sent = 0;
+    while (sent < client->out.size)
+    {
+        ssize_t n = send(client->fd, client->out.data + sent, client->out.size - sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            CloseClient(server, slot);
+            return -1;
+        }
+        sent += n;
+    }
+    ConsumeBytes(&client->out, sent);
+    int writing = client->out.size > 0;
+    if (writing != client->writing)
+    {
+        WatchClient(server, slot, writing ? EPOLLIN | EPOLLOUT : EPOLLIN);
+        client->writing = writing;
+    }
+    return 0;
+}
+
+// Queue a message - written straight from the shared tick buffer when nothing is waiting, copied only if the socket is full
+void SendToClient(SERVER* server, int slot, const unsigned char* data, size_t size)
+{
+    CLIENT* client = &server->clients[slot];
+    size_t sent = 0;
+    while (client->out.size == 0 && sent < size)
+    {
+        ssize_t n = send(client->fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            CloseClient(server, slot);
+            return;
+        }
+        if (n < 0)
+        {
+            break;
+        }
+        sent += n;
+    }
+    if (sent == size)
+    {
+        return;
+    }
+    if (client->out.size + size - sent > SERVER_OUT_LIMIT)
+    {
+        server->dropped++;
+        CloseClient(server, slot);
+        return;
+    }
+    PutBytes(&client->out, data + sent, size - sent);
+    FlushClient(server, slot);
+}
+
+void AcceptClients(SERVER* server, FILE* log)
+{
+    while (1)
+    {
+        int fd = accept(server->listenFd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;     // EAGAIN - all accepted
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int slot = 0;
+        while (slot < NET_MAX_FROGS && server->clients[slot].fd >= 0)
+        {
+            slot++;
+        }
+        if (slot == NET_MAX_FROGS)
+        {
+            close(fd);
+            fprintf(log, "server: full, connection refused\n");
+            continue;
+        }
+        CLIENT* client = &server->clients[slot];
+        client->fd = fd;
+        client->generation++;
+        client->role = -1;
+        client->alive = 0;
+        client->nKeys = 0;
+        client->full = 0;
+        client->writing = 0;
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = (uint64_t)client->generation << 32 | (uint32_t)slot;
+        epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event);
+        server->nSlots = slot + 1 > server->nSlots ? slot + 1 : server->nSlots;
+        server->nClients++;
+        server->maxClients = server->nClients > server->maxClients ? server->nClients : server->maxClients;
+    }
+}
+
+// Answer HELLO - the client learns its id and checks it runs the same config, then gets a full tick
+void WelcomeClient(SERVER* server, int slot, int spectate)
+{
+    CLIENT* client = &server->clients[slot];
+    client->role = spectate ? 1 : 0;
+    if (!spectate)
+    {
+        SpawnFrog(server, client);
+    }
+    client->full = 1;
+    NET_BUFFER message = { 0 };
+    size_t start = BeginMessage(&message, MSG_WELCOME);
+    uint64_t cfgHash = HashCfg(server->cfg);
+    PutBytes(&message, &cfgHash, sizeof(cfgHash));
+    PutU16(&message, spectate ? NET_SPECTATOR : (uint16_t)slot);
+    PutU16(&message, (uint16_t)server->sim->cars->count);
+    EndMessage(&message, start);
+    SendToClient(server, slot, message.data, message.size);
+    FreeBuffer(&message);
+}
+
+// Read the client's messages - two bytes each
+void ReadClient(SERVER* server, int slot, FILE* log)
+{
+    CLIENT* client = &server->clients[slot];
+    unsigned char chunk[256];
+    while (1)
+    {
+        ssize_t n = recv(client->fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (n <= 0)
+        {
+            fprintf(log, "server: client %d left\n", slot);
+            CloseClient(server, slot);
+            return;
+        }
+        PutBytes(&client->in, chunk, n);
+    }
+
+    size_t used = 0;
+    for (; used + 2 <= client->in.size; used += 2)
+    {
+        int type = client->in.data[used];
+        int value = client->in.data[used + 1];
+        if (type == MSG_HELLO && client->role < 0)
+        {
+            WelcomeClient(server, slot, value != 0);
+            fprintf(log, "server: client %d joined as a %s (%d clients)\n", slot, value ? "spectator" : "player", server->nClients);
+        }
+        else if (type == MSG_KEY && client->role >= 0)
+        {
+            if (client->alive && client->nKeys < SERVER_KEYS)
+            {
+                client->keys[client->nKeys++] = (unsigned char)value;
+            }
+        }
+        else
+        {
+            fprintf(log, "server: client %d sent an unexpected message, disconnected\n", slot);
+            CloseClient(server, slot);
+            return;
+        }
+        if (client->fd < 0)
+        {
+            return;     // could not take the welcome
+        }
+    }
+    ConsumeBytes(&client->in, used);
+}
+
+
+// --- GAME FUNCTIONS ---
+void EndRound(SERVER* server, int slot, GameResult result)
+{
+    CLIENT* client = &server->clients[slot];
+    client->alive = 0;
+    unsigned char message[NET_HEADER + 1];
+    uint32_t length = 2;
+    memcpy(message, &length, sizeof(length));
+    message[4] = MSG_RESULT;
+    message[5] = (unsigned char)result;
+    SendToClient(server, slot, message, sizeof(message));
+}
+
+// One step of the shared game - every frog takes its oldest key, the cars move once for all of them
+void StepServer(SERVER* server)
+{
+    SIM* sim = server->sim;
+    CFG* cfg = server->cfg;
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        if (client->fd < 0 || !client->alive || client->nKeys == 0)
+        {
+            continue;
+        }
+        int key = client->keys[0];
+        memmove(client->keys, client->keys + 1, --client->nKeys);
+        if (key == cfg->controls->quit)
+        {
+            EndRound(server, i, INTERRUPTED);
+            continue;
+        }
+        MoveFrog(&client->frog, cfg->controls, key, cfg->frog->moveFactor, sim->timer->frameNo);
+    }
+
+    StepCars(sim);
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        if (client->fd < 0 || !client->alive)
+        {
+            continue;
+        }
+        OBJ* frog = &client->frog;
+        if (DestReached(frog, sim->dest))
+        {
+            EndRound(server, i, SUCCESS);
+        }
+        else if (CollideSprites(sim->lanes, sim->cars, sim->sprites, GetSprite(sim->sprites, frog->sprite), frog->x, frog->y) >= 0)
+        {
+            EndRound(server, i, FAILURE);
+        }
+    }
+
+    if (UpdateTimer(sim->timer, cfg->timing->initialTime))
+    {
+        for (int i = 0; i < server->nSlots; i++)
+        {
+            if (server->clients[i].fd >= 0 && server->clients[i].alive)
+            {
+                EndRound(server, i, TIME_OVER);
+            }
+        }
+        StartRound(server);
+    }
+}
+
+
+// --- BROADCAST FUNCTIONS ---
+// Tick message - full lists every car and frog on the road, a delta only the ones that have moved since the last tick
+void EncodeTick(SERVER* server, NET_BUFFER* buffer, int full)
+{
+    SIM* sim = server->sim;
+    CAR_POOL* cars = sim->cars;
+    buffer->size = 0;
+    size_t start = BeginMessage(buffer, MSG_TICK);
+    size_t headerAt = buffer->size;
+    TICK_HEADER header;
+    memset(&header, 0, sizeof(header));
+    PutBytes(buffer, &header, sizeof(header));
+
+    for (int i = 0; i < cars->count; i++)
+    {
+        if (full || cars->x[i] != server->carX[i])
+        {
+            PutU16(buffer, (uint16_t)i);
+            PutU16(buffer, (uint16_t)(int16_t)cars->x[i]);
+            header.nCars++;
+        }
+    }
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        int onRoad = client->fd >= 0 && client->alive;
+        int x = onRoad ? client->frog.x : 0;
+        int y = onRoad ? client->frog.y : NET_GONE;
+        int changed = y != client->sentY || (onRoad && x != client->sentX);
+        if ((full && onRoad) || (!full && changed))
+        {
+            PutU16(buffer, (uint16_t)i);
+            PutU16(buffer, (uint16_t)(int16_t)x);
+            PutU16(buffer, (uint16_t)(int16_t)y);
+            header.nFrogs++;
+        }
+    }
+
+    header.frame = sim->timer->frameNo;
+    header.timeLeft = sim->timer->timeLeft;
+    header.destX = (int16_t)sim->dest->x;
+    header.destY = (int16_t)sim->dest->y;
+    header.full = (uint8_t)full;
+    memcpy(buffer->data + headerAt, &header, sizeof(header));
+    EndMessage(buffer, start);
+}
+
+// What has been sent is now the state every client has
+void MarkSent(SERVER* server)
+{
+    CAR_POOL* cars = server->sim->cars;
+    memcpy(server->carX, cars->x, cars->count * sizeof(int));
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        int onRoad = client->fd >= 0 && client->alive;
+        client->sentX = onRoad ? client->frog.x : 0;
+        client->sentY = onRoad ? client->frog.y : NET_GONE;
+    }
+    while (server->nSlots > 0 && server->clients[server->nSlots - 1].fd < 0)
+    {
+        server->nSlots--;   // every client knows the frogs of the closed slots are gone
+    }
+}
+
+// Send the tick to every client - the delta is encoded once, the full tick only if a client needs it
+void Broadcast(SERVER* server)
+{
+    EncodeTick(server, &server->delta, 0);
+    int fullEncoded = 0;
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        if (client->fd >= 0 && client->role >= 0 && client->full && !fullEncoded)
+        {
+            EncodeTick(server, &server->full, 1);
+            fullEncoded = 1;
+        }
+    }
+    MarkSent(server);
+    for (int i = 0; i < server->nSlots; i++)
+    {
+        CLIENT* client = &server->clients[i];
+        if (client->fd < 0 || client->role < 0)
+        {
+            continue;
+        }
+        NET_BUFFER* tick = client->full ? &server->full : &server->delta;
+        client->full = 0;
+        SendToClient(server, i, tick->data, tick->size);
+    }
+    server->ticks++;
+    server->tickBytes += server->delta.size;
+}
+
+
+// --- SERVER FUNCTIONS ---
+int ListenUnix(const char* path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    unlink(path);   // left over by a server that has not exited cleanly
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void HandleEvent(SERVER* server, struct epoll_event* event, FILE* log)
+{
+    if (event->data.u64 == LISTENER)
+    {
+        AcceptClients(server, log);
+        return;
+    }
+    int slot = (int)(uint32_t)event->data.u64;
+    CLIENT* client = &server->clients[slot];
+    if (client->fd < 0 || client->generation != (uint32_t)(event->data.u64 >> 32))
+    {
+        return;     // closed earlier in this batch
+    }
+    if (event->events & EPOLLOUT)
+    {
+        if (FlushClient(server, slot) != 0)
+        {
+            return;
+        }
+    }
+    if (event->events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+    {
+        ReadClient(server, slot, log);
+    }
+}
+
+int RunServer(CFG* cfg, const char* path, uint64_t seed, FILE* log)
+{
+    if (cfg->area->endless || cfg->cars->nCars > UINT16_MAX || cfg->area->playableRows > INT16_MAX || cfg->area->cols > INT16_MAX)
+    {
+        fprintf(log, "server: the endless road and worlds over 32767 rows/columns or 65535 cars are not supported\n");
+        return -1;
+    }
+    SERVER server;
+    memset(&server, 0, sizeof(SERVER));
+    server.cfg = cfg;
+    server.seed = seed;
+    server.path = path;
+    server.listenFd = ListenUnix(path);
+    if (server.listenFd < 0)
+    {
+        fprintf(log, "server: cannot listen on %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER;
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopServer;     // no SA_RESTART - epoll_wait returns on the signal
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    server.sprites = InitSpriteAtlas(cfg);
+    server.arena = InitArena(SimArenaSize(cfg));
+    server.clients = (CLIENT*)calloc(NET_MAX_FROGS, sizeof(CLIENT));
+    for (int i = 0; i < NET_MAX_FROGS; i++)
+    {
+        server.clients[i].fd = -1;
+        server.clients[i].sentY = NET_GONE;
+    }
+    server.carX = (int*)malloc((cfg->cars->nCars + 1) * sizeof(int));
+    StartRound(&server);
+    MarkSent(&server);
+    fprintf(log, "server: listening on %s\n", path);
+
+    PACER pacer;
+    InitPacer(&pacer, cfg->timing->frameTime, 0);
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!serverStop)
+    {
+        int64_t wait = pacer.nextStep - NowNs();
+        int timeout = wait > 0 ? (int)((wait + 999999) / 1000000) : 0;
+        int n = epoll_wait(server.epollFd, events, SERVER_MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR)
+        {
+            break;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            HandleEvent(&server, &events[i], log);
+        }
+        int steps = DueSteps(&pacer);
+        for (int i = 0; i < steps; i++)
+        {
+            StepServer(&server);
+        }
+        if (steps > 0)
+        {
+            Broadcast(&server);
+        }
+    }
+
+    fprintf(log, "server: %ld ticks, %.1f bytes per delta tick, %ld clients at most, %ld dropped as too slow, %ld steps dropped\n",
+        server.ticks, server.ticks ? (double)server.tickBytes / server.ticks : 0.0, server.maxClients, server.dropped, pacer.dropped);
+    for (int i = 0; i < server.nSlots; i++)
+    {
+        if (server.clients[i].fd >= 0)
+        {
+            CloseClient(&server, i);
+        }
+    }
+    close(server.epollFd);
+    close(server.listenFd);
+    unlink(path);
+    FreeBuffer(&server.delta);
+    FreeBuffer(&server.full);
+    free(server.clients);
+    free(server.carX);
+    FreeArena(server.arena);
+    FreeSpriteAtlas(server.sprites);
+    return 0;
+}
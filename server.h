@@ -0,0 +1,57 @@
+// server.h
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+#include "sim.h"
+#include "net.h"
+
+#define SERVER_MAX_EVENTS 64        // epoll events handled per wake-up
+#define SERVER_OUT_LIMIT (1 << 20)  // bytes queued for a client before it is dropped as too slow
+#define SERVER_KEYS 8               // keys queued per player, the frog takes one per step
+
+// Client connection - the slot is the player id
+typedef struct {
+    int fd;             // -1 for a free slot
+    uint32_t generation;    // tells epoll events of an earlier client of the slot apart
+    int role;           // -1 until HELLO, 0 for a player, 1 for a spectator
+    int alive;          // the frog is on the road in this round
+    OBJ frog;
+    unsigned char keys[SERVER_KEYS];
+    int nKeys;
+    int sentX, sentY;   // frog of the slot in the last tick sent, sentY is NET_GONE if it was not on the road
+    int full;           // 1 if the next tick sent has to be a full one
+    int writing;        // 1 while EPOLLOUT is requested
+    NET_BUFFER in;
+    NET_BUFFER out;     // what the socket has not taken yet
+} CLIENT;
+
+// Game server - one authoritative game with a frog per player, rounds restart when the time is over
+// Every step is broadcast as a delta: the cars and frogs whose position has changed, encoded once for all clients
+typedef struct {
+    CFG* cfg;
+    SPRITE_ATLAS* sprites;
+    ARENA* arena;       // the game of the current round
+    SIM* sim;           // cars, destination and clock - its own frog is the template of the players' frogs
+    uint64_t seed;
+    int round;
+    const char* path;
+    int listenFd;
+    int epollFd;
+    CLIENT* clients;    // NET_MAX_FROGS slots
+    int nSlots;         // slots in use are below this
+    int nClients;
+    int* carX;          // car positions in the last tick sent
+    NET_BUFFER delta;   // tick of the current step
+    NET_BUFFER full;    // full tick of the current step, encoded only when a client needs it
+    long ticks;
+    long tickBytes;     // bytes of the delta ticks
+    long maxClients;
+    long dropped;       // clients disconnected for not keeping up
+} SERVER;
+
+// --- SERVER FUNCTIONS ---
+// Serve games of the config on a Unix socket at path until SIGINT or SIGTERM - 0 on a clean exit, -1 on error
+int RunServer(CFG* cfg, const char* path, uint64_t seed, FILE* log);
+
+#endif // SERVER_H
@@ -0,0 +1,406 @@
+// sim.c
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+
+// --- OBJ FUNCTIONS ---
+// Move the game object along both axes by 1, within its boundaries
+void MoveObj(OBJ* obj, int dx, int dy)
+{
+    if ((dy == 1) && (obj->y + obj->height < obj->ymax))
+    {
+        obj->y += dy;
+    }
+    else if ((dy == -1) && (obj->y > obj->ymin))
+    {
+        obj->y += dy;
+    }
+
+    if ((dx == 1) && (obj->x + obj->width < obj->xmax))
+    {
+        obj->x += dx;
+    }
+    else if ((dx == -1) && (obj->x > obj->xmin))
+    {
+        obj->x += dx;
+    }
+}
+
+int Collision(OBJ* obj, OBJ* other)
+{
+    return ((
+        (obj->y >= other->y && obj->y < other->y + other->height) ||
+        (other->y >= obj->y && other->y < obj->y + obj->height)
+        ) && (
+            (obj->x >= other->x && obj->x < other->x + other->width) ||
+            (other->x >= obj->x && other->x < obj->x + obj->width)
+            )) ? 1 : 0;
+}
+
+void SetObjPosition(OBJ* obj, int x, int y)
+{
+    obj->x = x;
+    obj->y = y;
+}
+
+// Frog initializer
+OBJ* InitFrog(FROG_CFG* cfg, int rows, int cols, int sprite, ARENA* arena)
+{
+    OBJ* frog = (OBJ*)ArenaAlloc(arena, sizeof(OBJ));
+    frog->width = cfg->width;
+    frog->height = cfg->height;
+    frog->moveFactor = 0;
+    frog->xmin = 1;
+    frog->xmax = cols - 1;
+    frog->ymin = 1;
+    frog->ymax = rows - 1;
+
+    frog->sprite = sprite;
+    SetObjPosition(frog, (cols - frog->width) / 2, rows - frog->height - 1);
+    return frog;
+}
+
+// Frog movement - returns 1 if the key has been accepted (cooldown has passed), 0 otherwise
+int MoveFrog(OBJ* frog, CONTROLS_CFG* cfg, int key, int moveFactor, int frame)
+{
+    if (frame - frog->moveFactor >= moveFactor)   // movement cooldown condition
+    {
+        if (key == cfg->up)
+        {
+            MoveObj(frog, 0, -1);
+        }
+        else if (key == cfg->down)
+        {
+            MoveObj(frog, 0, 1);
+        }
+        else if (key == cfg->left)
+        {
+            MoveObj(frog, -1, 0);
+        }
+        else if (key == cfg->right)
+        {
+            MoveObj(frog, 1, 0);
+        }
+        frog->moveFactor = frame;
+        return 1;
+    }
+    return 0;
+}
+
+
+// --- DESTINATION (DEST) FUNCTIONS ---
+// Destination initializer
+DEST* InitDest(int cols, int width, ARENA* arena)
+{
+    DEST* dest = (DEST*)ArenaAlloc(arena, sizeof(DEST));
+    dest->width = width;
+    dest->height = 1;   // single row
+    dest->x = (cols - dest->width) / 2;
+    dest->y = 1;
+    return dest;
+}
+
+// Returns 1 if the frog has reached the destination, 0 otherwise
+int DestReached(OBJ* frog, DEST* dest)
+{
+    return (frog->y == dest->y && frog->x == dest->x) ? 1 : 0;
+}
+
+// Put the destination into the gap above the last lane before the next checkpoint - rows above the world until
+// the road has scrolled that far, the column comes from the lane's random bits
+void PlaceCheckpoint(SIM* sim)
+{
+    CAR_POOL* cars = sim->cars;
+    DEST* dest = sim->dest;
+    int lane = (sim->checkpoints + 1) * CHECKPOINT_LANES - 1;
+    int columns = sim->cols - 1 - dest->width;  // the frog's x range
+    dest->y = (cars->base + cars->count - 1 - lane) * (cars->height + sim->frog->height);
+    dest->x = 1 + (columns > 1 ? (int)((LaneBits(cars, lane) >> 48) % (uint64_t)columns) : 0);
+}
+
+
+// --- TIMER FUNCTIONS ---
+// TIMER initializer
+TIMER* InitTimer(TIMING_CFG* cfg, ARENA* arena)
+{
+    TIMER* timer = (TIMER*)ArenaAlloc(arena, sizeof(TIMER));
+    timer->frameNo = 1;
+    timer->frameTime = cfg->frameTime;
+    timer->timeLeft = cfg->initialTime / 1.0;
+    timer->baseFrame = 0;
+    timer->baseElapsed = 0;
+    return timer;
+}
+
+double TimeLeftAt(TIMER* timer, int initialTime, int frameNo)
+{
+    return initialTime - ((timer->baseElapsed + (long)(frameNo - timer->baseFrame) * timer->frameTime) / 1000.0);
+}
+
+void RetimeTimer(TIMER* timer, int frameTime)
+{
+    timer->baseElapsed += (long)(timer->frameNo - timer->baseFrame) * timer->frameTime;
+    timer->baseFrame = timer->frameNo;
+    timer->frameTime = frameTime;
+}
+
+// Advance the game clock by one frame - waiting for the frame is up to the caller
+int UpdateTimer(TIMER* timer, int initialTime)
+{
+    timer->frameNo++;
+    timer->timeLeft = TimeLeftAt(timer, initialTime, timer->frameNo);
+    if (timer->timeLeft < timer->frameTime / 1000.0)
+    {
+        timer->timeLeft = 0;
+    }
+    return timer->timeLeft == 0 ? 1 : 0; // 1 if time has elapsed, 0 otherwise
+}
+
+
+// --- SIM FUNCTIONS ---
+size_t SimArenaSize(CFG* cfg)
+{
+    int laneRows = cfg->cars->nCars * (cfg->cars->height + cfg->frog->height) + cfg->frog->height + 1;
+    return sizeof(SIM) + sizeof(TIMER) + sizeof(OBJ) + sizeof(DEST) + 4 * ARENA_ALIGN +
+        CarPoolSize(cfg->cars->nCars) + LaneIndexSize(cfg->cars->nCars, laneRows);
+}
+
+// Simulation initializer - the playable area is taken from the area config
+SIM* InitSim(CFG* cfg, SPRITE_ATLAS* sprites, uint64_t seed, ARENA* arena)
+{
+    SIM* sim = (SIM*)ArenaAlloc(arena, sizeof(SIM));
+    sim->cfg = cfg;
+    sim->sprites = sprites;
+    sim->seed = seed;
+    SeedRng(&sim->rng, seed);
+    sim->rows = cfg->area->playableRows;
+    sim->cols = cfg->area->cols;
+    sim->viewY = 0;
+    sim->viewRows = sim->rows;
+    sim->timer = InitTimer(cfg->timing, arena);
+    sim->frog = InitFrog(cfg->frog, sim->rows, sim->cols, sprites->frog, arena);
+    sim->cars = InitCarPool(cfg->cars, sim->cols, cfg->frog->height, sim->timer->frameNo, sprites->car, &sim->rng, arena);
+    sim->lanes = InitLaneIndex(sim->cars, arena);
+    sim->dest = InitDest(sim->cols, cfg->frog->width, arena); // destination is a single row of the frog's width
+    sim->checkpoints = 0;
+    if (cfg->area->endless)
+    {
+        for (int lane = 0; lane < sim->cars->count; lane++)
+        {
+            GenerateLane(sim->cars, lane, cfg->cars->moveFactor);
+        }
+        ResyncCars(sim->cars);
+        PlaceCheckpoint(sim);
+    }
+    sim->input = NO_KEY;
+    sim->result = RUNNING;
+    sim->profiler = NULL;
+    return sim;
+}
+
+// Step the cars of the view and the lanes around the frog, the others are evaluated when queried
+void UpdateEagerCars(SIM* sim)
+{
+    OBJ* frog = sim->frog;
+    int ymin = frog->y - EAGER_MARGIN;
+    int ymax = frog->y + frog->height + EAGER_MARGIN;
+    if (sim->viewRows > 0)
+    {
+        ymin = sim->viewY < ymin ? sim->viewY : ymin;
+        ymax = sim->viewY + sim->viewRows > ymax ? sim->viewY + sim->viewRows : ymax;
+    }
+    SetEagerCars(sim->cars, ymin, ymax);
+}
+
+// Keep the frog in the lower half of the endless road - the bottom lane slot is recycled as the next lane at the top
+// and everything moves one lane pitch down, at most once per step (the frog climbs one row at a time)
+void ScrollRoad(SIM* sim)
+{
+    OBJ* frog = sim->frog;
+    CAR_POOL* cars = sim->cars;
+    int pitch = cars->height + frog->height;
+    if (frog->y + frog->height / 2 >= sim->rows / 2 || frog->y + pitch + frog->height > frog->ymax)
+    {
+        return;
+    }
+    ScrollCars(cars, sim->cfg->cars->moveFactor);
+    frog->y += pitch;
+    PlaceCheckpoint(sim);
+}
+
+void StepCars(SIM* sim)
+{
+    UpdateEagerCars(sim);
+    UpdateCars(sim->cars);
+    UpdateLaneIndex(sim->lanes, sim->cars);
+}
+
+// End a phase of the step if the game is profiled
+void ProfileSim(SIM* sim, ProfilePhase phase)
+{
+    if (sim->profiler)
+    {
+        EndPhase(sim->profiler, phase);
+    }
+}
+
+// Single frame of the game - same order as the original main loop
+
+GameResult StepSim(SIM* sim, int key)
+{
+    if (sim->result != RUNNING)
+    {
+        return sim->result;
+    }
+    sim->input = NO_KEY;
+    if (key == sim->cfg->controls->quit)
+    {
+        sim->input = key;
+        return sim->result = INTERRUPTED;
+    }
+    if (key != NO_KEY && MoveFrog(sim->frog, sim->cfg->controls, key, sim->cfg->frog->moveFactor, sim->timer->frameNo))
+    {
+        sim->input = key;
+    }
+    if (sim->cfg->area->endless)
+    {
+        ScrollRoad(sim);
+    }
+    ProfileSim(sim, PHASE_FROG);
+    StepCars(sim);
+    ProfileSim(sim, PHASE_CARS);
+    if (DestReached(sim->frog, sim->dest))
+    {
+        if (!sim->cfg->area->endless)
+        {
+            return sim->result = SUCCESS;
+        }
+        sim->checkpoints++;     // the endless road has no end - the destination moves on
+        PlaceCheckpoint(sim);
+    }
+    OBJ* frog = sim->frog;
+    int hit = CollideSprites(sim->lanes, sim->cars, sim->sprites, GetSprite(sim->sprites, frog->sprite), frog->x, frog->y);
+    ProfileSim(sim, PHASE_COLLISION);
+    if (hit >= 0)
+    {
+        return sim->result = FAILURE;
+    }
+    if (UpdateTimer(sim->timer, sim->cfg->timing->initialTime + sim->checkpoints * CHECKPOINT_TIME))
+    {
+        return sim->result = TIME_OVER;
+    }
+    return RUNNING;
+}
+
+// Fingerprint of everything that changes during a game - equal hashes mean the games have played out the same
+uint64_t SimStateHash(SIM* sim)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    CAR_POOL* cars = sim->cars;
+    SyncCars(cars, 0, cars->count);
+    hash = HashBytes(hash, &sim->frog->x, sizeof(int));
+    hash = HashBytes(hash, &sim->frog->y, sizeof(int));
+    hash = HashBytes(hash, &sim->frog->moveFactor, sizeof(int));
+    hash = HashBytes(hash, &sim->timer->frameNo, sizeof(int));
+    hash = HashBytes(hash, &sim->result, sizeof(GameResult));
+    hash = HashBytes(hash, &sim->rng, sizeof(RNG));
+    hash = HashBytes(hash, &cars->base, sizeof(int));
+    hash = HashBytes(hash, &sim->checkpoints, sizeof(int));
+    hash = HashBytes(hash, cars->x, cars->count * sizeof(int));
+    hash = HashBytes(hash, cars->direction, cars->count * sizeof(int));
+    hash = HashBytes(hash, cars->phase, cars->count * sizeof(int));
+    hash = HashBytes(hash, cars->disappearing, cars->count * sizeof(int));
+    hash = HashBytes(hash, cars->spawns, cars->count * sizeof(int));
+    return hash;
+}
+
+int SimDistance(SIM* sim)
+{
+    OBJ* frog = sim->frog;
+    int start = sim->rows - frog->height - 1;   // InitFrog
+    return sim->cars->base * (sim->cars->height + frog->height) + start - frog->y;
+}
+
+void ApplyCfg(SIM* sim, CFG* cfg)
+{
+    int moveFactor = sim->cfg->cars->moveFactor;
+    sim->cfg = cfg;
+    if (cfg->timing->frameTime != sim->timer->frameTime)
+    {
+        RetimeTimer(sim->timer, cfg->timing->frameTime);
+    }
+    if (cfg->cars->moveFactor != moveFactor)
+    {
+        RetimeCars(sim->cars, cfg->cars->moveFactor, cfg->area->endless);
+    }
+}
+
+
+// --- STATE FUNCTIONS ---
+size_t SimStateSize(SIM* sim)
+{
+    return sizeof(SIM_STATE) + 5 * sim->cars->count * sizeof(int32_t);
+}
+
+void SaveSimState(SIM* sim, void* buffer)
+{
+    SIM_STATE state;    // copied in and out whole - the buffer need not be aligned (keyframes of a recording are not)
+    CAR_POOL* cars = sim->cars;
+    SyncCars(cars, 0, cars->count);
+    memset(&state, 0, sizeof(SIM_STATE));
+    state.frameNo = sim->timer->frameNo;
+    state.timeLeft = sim->timer->timeLeft;
+    state.result = sim->result;
+    state.frogX = sim->frog->x;
+    state.frogY = sim->frog->y;
+    state.frogCooldown = sim->frog->moveFactor;
+    state.rng = sim->rng;
+    state.nCars = cars->count;
+    state.scrolled = cars->base;
+    state.checkpoints = sim->checkpoints;
+    memcpy(buffer, &state, sizeof(SIM_STATE));
+
+    size_t array = cars->count * sizeof(int32_t);
+    char* arrays = (char*)buffer + sizeof(SIM_STATE);
+    memcpy(arrays, cars->x, array);
+    memcpy(arrays + array, cars->direction, array);
+    memcpy(arrays + 2 * array, cars->phase, array);
+    memcpy(arrays + 3 * array, cars->disappearing, array);
+    memcpy(arrays + 4 * array, cars->spawns, array);
+}
+
+void LoadSimState(SIM* sim, const void* buffer)
+{
+    SIM_STATE state;
+    memcpy(&state, buffer, sizeof(SIM_STATE));
+    CAR_POOL* cars = sim->cars;
+    sim->timer->frameNo = state.frameNo;
+    sim->timer->timeLeft = state.timeLeft;
+    sim->result = state.result;
+    sim->frog->x = state.frogX;
+    sim->frog->y = state.frogY;
+    sim->frog->moveFactor = state.frogCooldown;
+    sim->rng = state.rng;
+    sim->input = NO_KEY;
+    sim->checkpoints = state.checkpoints;
+    if (sim->cfg->area->endless)
+    {
+        cars->base = state.scrolled;
+        for (int lane = cars->base; lane < cars->base + cars->count; lane++)
+        {
+            GenerateLane(cars, lane, sim->cfg->cars->moveFactor);   // the speeds of the lanes, the state is overwritten below
+        }
+        PlaceCheckpoint(sim);
+    }
+
+    size_t array = cars->count * sizeof(int32_t);
+    const char* arrays = (const char*)buffer + sizeof(SIM_STATE);
+    memcpy(cars->x, arrays, array);
+    memcpy(cars->direction, arrays + array, array);
+    memcpy(cars->phase, arrays + 2 * array, array);
+    memcpy(cars->disappearing, arrays + 3 * array, array);
+    memcpy(cars->spawns, arrays + 4 * array, array);
+    ResyncCars(cars);
+    UpdateLaneIndex(sim->lanes, cars);
+}
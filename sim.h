@@ -0,0 +1,125 @@
+// sim.h
+#ifndef SIM_H
+#define SIM_H
+
+#include "cfg.h"
+#include "cars.h"
+#include "lanes.h"
+#include "sprite.h"
+#include "rng.h"
+#include "profile.h"
+
+// --- CONSTANTS ---
+// Result of a simulation step - the first four values end the game
+typedef enum {
+    SUCCESS,        // reached destination
+    FAILURE,        // died
+    TIME_OVER,      // time is over
+    INTERRUPTED,    // decision to quit
+    RUNNING         // game still in progress
+} GameResult;
+
+#define NO_KEY (-1)  // no input in the current frame (same value as ncurses ERR)
+#define EAGER_MARGIN 1  // rows around the frog whose cars are stepped every frame
+#define CHECKPOINT_LANES 8  // lanes between the checkpoints of the endless road
+#define CHECKPOINT_TIME 10  // seconds added for every checkpoint reached
+
+
+// --- DATA STRUCTURES ---
+// Game object structure - used for the frog, cars are kept in a CAR_POOL
+typedef struct {
+    int moveFactor;     // frame of the last move (cooldown)
+    int x, y;           // top-left corner coordinates
+    int xmin, xmax;     // movement boundaries
+    int ymin, ymax;
+    int width, height;
+    int sprite;         // id in the sprite atlas
+} OBJ;
+
+// Destination structure - a moving checkpoint on the endless road
+typedef struct {
+    int x, y;           // top-left corner coordinates
+    int width, height;
+} DEST;
+
+// Timer structure
+typedef struct {
+    int frameTime;
+    float timeLeft;
+    int frameNo;
+    int baseFrame;      // frame the frame time last changed in - the frames before it took baseElapsed ms
+    long baseElapsed;
+} TIMER;
+
+// Serialized state of a game - followed by the car x, direction, phase, disappearing and spawns arrays
+typedef struct {
+    int32_t frameNo;
+    float timeLeft;
+    int32_t result;
+    int32_t frogX, frogY;
+    int32_t frogCooldown;   // OBJ::moveFactor of the frog
+    RNG rng;
+    int32_t nCars;
+    int32_t scrolled;       // CAR_POOL::base - lanes recycled by the endless road
+    int32_t checkpoints;
+    int32_t reserved;
+} SIM_STATE;
+
+// Simulation state - everything needed to play a game, no terminal involved
+typedef struct {
+    CFG* cfg;
+    SPRITE_ATLAS* sprites;  // shared by all games of the config
+    uint64_t seed;
+    RNG rng;                // all randomness of the game comes from here
+    int rows, cols;     // playable area, including its border
+    int viewY, viewRows;    // rows drawn every frame - cars elsewhere are simulated lazily
+    OBJ* frog;
+    CAR_POOL* cars;
+    LANE_INDEX* lanes;  // cars by row, for collision and proximity queries
+    DEST* dest;
+    TIMER* timer;
+    int checkpoints;        // reached on the endless road, each one adds CHECKPOINT_TIME
+    int input;              // key accepted in the last step, NO_KEY if none
+    GameResult result;
+    PROFILER* profiler;     // times the phases of every step, NULL if not profiled
+} SIM;
+
+
+// --- SIM FUNCTIONS ---
+// Move the game object along both axes by 1, within its boundaries
+void MoveObj(OBJ* obj, int dx, int dy);
+int Collision(OBJ* obj, OBJ* other);
+int DestReached(OBJ* frog, DEST* dest);
+// Frog movement - returns 1 if the key has been accepted (cooldown has passed), 0 otherwise
+int MoveFrog(OBJ* frog, CONTROLS_CFG* cfg, int key, int moveFactor, int frame);
+// Advance the game clock by one frame - returns 1 if the time is over
+int UpdateTimer(TIMER* timer, int initialTime);
+// Seconds left in the given frame (not clamped at 0)
+double TimeLeftAt(TIMER* timer, int initialTime, int frameNo);
+// Change the frame time - the time played so far stays, only the frames from now on take the new one
+void RetimeTimer(TIMER* timer, int frameTime);
+
+// Arena memory needed by a game of the given configuration
+size_t SimArenaSize(CFG* cfg);
+// Create a new game for the given configuration - everything lives in the arena, reset it to end the game
+SIM* InitSim(CFG* cfg, SPRITE_ATLAS* sprites, uint64_t seed, ARENA* arena);
+// Advance the game by one frame; key is the input of this frame or NO_KEY
+GameResult StepSim(SIM* sim, int key);
+// The cars' part of a step - move them and update the lane index, no frog involved (StepSim, the game server)
+void StepCars(SIM* sim);
+uint64_t SimStateHash(SIM* sim);
+// Rows the frog has climbed from its start - the score of the endless road
+int SimDistance(SIM* sim);
+// Switch a running game to a config of the same world (SameWorld) - timing, speeds and controls apply from the next step
+// The time played so far stays and only the frames from now on take the new frame time, the cars keep their positions
+void ApplyCfg(SIM* sim, CFG* cfg);
+
+// --- STATE FUNCTIONS ---
+// Bytes needed to store the state of the game
+size_t SimStateSize(SIM* sim);
+// The buffer may be unaligned
+void SaveSimState(SIM* sim, void* buffer);
+// Put a game of the same config into the saved state
+void LoadSimState(SIM* sim, const void* buffer);
+
+#endif // SIM_H
@@ -0,0 +1,512 @@
+// solver.c
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "solver.h"
+
+
+// --- BITSETS ---
+// Set bits [from, to) of a row, clipped to the row
+void SetBitRange(uint64_t* row, int words, int from, int to)
+{
+    from = from > 0 ? from : 0;
+    to = to < words * 64 ? to : words * 64;
+    for (int x = from; x < to; )
+    {
+        int bit = x & 63;
+        int n = to - x < 64 - bit ? to - x : 64 - bit;
+        row[x >> 6] |= (n == 64 ? ~0ULL : ((1ULL << n) - 1) << bit);
+        x += n;
+    }
+}
+
+// row |= the bits of src placed from bit at on, clipped to the row
+void OrBitsAt(uint64_t* row, int words, const uint64_t* src, int at)
+{
+    for (int w = 0; w < SOLVER_HIT_WORDS; w++)
+    {
+        uint64_t bits = src[w];
+        int from = at + 64 * w;
+        if (from < 0)
+        {
+            bits = from > -64 ? bits >> -from : 0;
+            from = 0;
+        }
+        int word = from >> 6;
+        int shift = from & 63;
+        if (bits && word < words)
+        {
+            row[word] |= bits << shift;
+            if (shift && word + 1 < words)
+            {
+                row[word + 1] |= bits >> (64 - shift);
+            }
+        }
+    }
+}
+
+int TestBit(const uint64_t* row, int x)
+{
+    return (int)((row[x >> 6] >> (x & 63)) & 1);
+}
+
+// dst |= src moved one position right (bit x - 1 to x), words [from, to) of dst
+void OrShiftedRight(uint64_t* dst, const uint64_t* src, int from, int to)
+{
+    for (int w = from; w < to; w++)
+    {
+        dst[w] |= src[w] << 1 | (w > 0 ? src[w - 1] >> 63 : 0);
+    }
+}
+
+// dst |= src moved one position left (bit x + 1 to x), words [from, to) of dst out of a row of words
+void OrShiftedLeft(uint64_t* dst, const uint64_t* src, int from, int to, int words)
+{
+    for (int w = from; w < to; w++)
+    {
+        dst[w] |= src[w] >> 1 | (w + 1 < words ? src[w + 1] << 63 : 0);
+    }
+}
+
+
+// --- OCCUPANCY ---
+// x of the cars of a lane at the given absolute frame of the car pool (not before the current one)
+const int* LaneCars(SOLVER* solver, int lane, int frame)
+{
+    SIM* sim = solver->sim;
+    LANE* cached = &sim->lanes->lanes[lane];
+    if (!solver->laneX[lane])
+    {
+        solver->laneX[lane] = (int*)malloc((size_t)solver->cacheFrames * cached->count * sizeof(int));
+        solver->laneFrame[lane] = (int*)malloc(solver->cacheFrames * sizeof(int));
+        for (int i = 0; i < solver->cacheFrames; i++)
+        {
+            solver->laneFrame[lane][i] = -1;
+        }
+    }
+    int slot = frame % solver->cacheFrames;
+    int* x = solver->laneX[lane] + (size_t)slot * cached->count;
+    if (solver->laneFrame[lane][slot] != frame)
+    {
+        for (int i = 0; i < cached->count; i++)
+        {
+            CAR_STATE car;
+            PredictCar(sim->cars, sim->lanes->order[cached->start + i], frame - sim->cars->frame, &car);
+            x[i] = car.x;
+        }
+        solver->laneFrame[lane][slot] = frame;
+    }
+    return x;
+}
+
+// Hit masks of the frog's and the cars' sprites - frog column i meets car column j when frog x = car x + j - i
+void InitHits(SOLVER* solver)
+{
+    SIM* sim = solver->sim;
+    SPRITE* frog = GetSprite(sim->sprites, sim->frog->sprite);
+    SPRITE* car = GetSprite(sim->sprites, sim->sprites->car);
+    int offsets = frog->height + car->height - 1;
+    solver->hits = (uint64_t*)calloc((size_t)offsets * SOLVER_HIT_WORDS, sizeof(uint64_t));
+    for (int k = 1 - car->height; k < frog->height; k++)
+    {
+        uint64_t* hit = solver->hits + (size_t)(k + car->height - 1) * SOLVER_HIT_WORDS;
+        for (int row = 0; row < car->height; row++)
+        {
+            if (row + k < 0 || row + k >= frog->height)
+            {
+                continue;   // this row of the car is above or below the frog
+            }
+            for (int i = 0; i < frog->width; i++)
+            {
+                for (int j = 0; j < car->width && (frog->mask[row + k] >> i & 1); j++)
+                {
+                    int bit = j - i + frog->width - 1;
+                    hit[bit >> 6] |= (car->mask[row] >> j & 1) << (bit & 63);
+                }
+            }
+        }
+    }
+}
+
+// Frog x positions in row y hit by any car at the given absolute frame, set in out - same overlap as CollideSprites
+void OrRowOccupancy(SOLVER* solver, int y, int frame, uint64_t* out)
+{
+    SIM* sim = solver->sim;
+    LANE_INDEX* index = sim->lanes;
+    int first = y - sim->cars->height + 1 > 0 ? y - sim->cars->height + 1 : 0;    // lanes whose cars reach the frog
+    int last = y + sim->frog->height - 1 < index->nRows - 1 ? y + sim->frog->height - 1 : index->nRows - 1;
+    for (int row = first; row <= last; row++)
+    {
+        if (index->rowLane[row] >= 0)
+        {
+            int lane = index->rowLane[row];
+            const int* x = LaneCars(solver, lane, frame);
+            const uint64_t* hit = solver->hits + (size_t)(row - y + sim->cars->height - 1) * SOLVER_HIT_WORDS;
+            for (int i = 0; i < index->lanes[lane].count; i++)
+            {
+                OrBitsAt(out, solver->words, hit, x[i] - sim->frog->width + 1);
+            }
+        }
+    }
+}
+
+
+// --- SOLVER FUNCTIONS ---
+SOLVER* InitSolver(SIM* sim)
+{
+    SOLVER* solver = (SOLVER*)malloc(sizeof(SOLVER));
+    int moveFactor = sim->cfg->frog->moveFactor;
+    int lanes = sim->lanes->nLanes > 0 ? sim->lanes->nLanes : 1;
+    solver->sim = sim;
+    solver->words = (sim->cols + 63) / 64;
+    solver->period = moveFactor > 1 ? moveFactor : 1;
+    solver->cacheFrames = SOLVER_CACHE_FRAMES;
+    solver->laneX = (int**)calloc(lanes, sizeof(int*));
+    solver->laneFrame = (int**)calloc(lanes, sizeof(int*));
+    solver->layers = (uint64_t*)calloc((size_t)(solver->period + 1) * SOLVER_CLASSES * sim->rows * solver->words, sizeof(uint64_t));
+    solver->rowFrom = (int*)calloc(solver->period + 1, sizeof(int));
+    solver->rowTo = (int*)calloc(solver->period + 1, sizeof(int));
+    solver->scratch = (uint64_t*)calloc((SOLVER_CLASSES + 3) * solver->words, sizeof(uint64_t));
+    InitHits(solver);
+    return solver;
+}
+
+// Row y of the states of a step (slot of the ring) that started with the given first action
+uint64_t* LayerRow(SOLVER* solver, int slot, int class, int y)
+{
+    return solver->layers + (((size_t)slot * SOLVER_CLASSES + class) * solver->sim->rows + y) * solver->words;
+}
+
+// Empty a slot of the ring - only its rows [rowFrom, rowTo) of the first classes can hold states
+void ClearLayer(SOLVER* solver, int slot, int classes)
+{
+    for (int class = 0; class < classes; class++)
+    {
+        for (int y = solver->rowFrom[slot]; y < solver->rowTo[slot]; y++)
+        {
+            memset(LayerRow(solver, slot, class, y), 0, solver->words * sizeof(uint64_t));
+        }
+    }
+    solver->rowFrom[slot] = 0;
+    solver->rowTo[slot] = 0;
+}
+
+// Steps until the time is over - the last one can still reach the destination (it is checked before the clock)
+int StepsLeft(SIM* sim)
+{
+    TIMER timer = *sim->timer;
+    int initialTime = sim->cfg->timing->initialTime + sim->checkpoints * CHECKPOINT_TIME;
+    int steps = 1;
+    while (!UpdateTimer(&timer, initialTime))
+    {
+        steps++;
+    }
+    return steps;
+}
+
+// Key of a first action, by class
+int ClassKey(SIM* sim, int class)
+{
+    CONTROLS_CFG* controls = sim->cfg->controls;
+    int keys[SOLVER_CLASSES] = { NO_KEY, controls->up, controls->down, controls->left, controls->right };
+    return keys[class];
+}
+
+// Build the states of step t - waits from step t - 1 (safe at t) and moves from step t - period (safe all the way
+// from the step after the move to t), within the frog's boundaries and the A* bound
+// Moves from the start (first is 1) go into the class of their direction, everything else keeps its class
+void ExpandStep(SOLVER* solver, int t, int start, int classes, int first, int horizon)
+{
+    SIM* sim = solver->sim;
+    OBJ* frog = sim->frog;
+    DEST* dest = sim->dest;
+    int words = solver->words;
+    int period = solver->period;
+    int ring = period + 1;
+    int out = t % ring;
+    int waits = (t - 1) % ring;
+    int moves = t - period >= start ? (t - period) % ring : -1;
+    uint64_t* moved = solver->scratch;
+    uint64_t* unsafe = moved + SOLVER_CLASSES * words;
+    uint64_t* window = unsafe + words;
+    uint64_t* mask = window + words;
+    ClearLayer(solver, out, classes);
+
+    int from = solver->rowFrom[waits];
+    int to = solver->rowTo[waits];
+    if (moves >= 0 && solver->rowFrom[moves] < solver->rowTo[moves])
+    {
+        from = from < to && from < solver->rowFrom[moves] - 1 ? from : solver->rowFrom[moves] - 1;
+        to = to > solver->rowTo[moves] + 1 ? to : solver->rowTo[moves] + 1;
+    }
+    from = from > frog->ymin ? from : frog->ymin;
+    to = to < frog->ymax - frog->height + 1 ? to : frog->ymax - frog->height + 1;
+    int reach = (horizon - t - 1) / period + 1;     // moves that still end in time, the last one onto the destination
+
+    for (int y = from; y < to; y++)
+    {
+        int spare = reach - abs(y - dest->y);
+        int xmin = dest->x - spare > frog->xmin ? dest->x - spare : frog->xmin;
+        int xmax = dest->x + spare < frog->xmax - frog->width ? dest->x + spare : frog->xmax - frog->width;
+        if (xmin > xmax)
+        {
+            continue;
+        }
+        int wfrom = xmin >> 6;     // words of the row that can hold states
+        int wto = (xmax >> 6) + 1;
+        size_t span = (wto - wfrom) * sizeof(uint64_t);
+        memset(mask + wfrom, 0, span);
+        SetBitRange(mask, words, xmin, xmax + 1);
+
+        for (int class = 0; class < classes; class++)
+        {
+            memset(moved + class * words + wfrom, 0, span);
+        }
+        int anyMove = 0;
+        for (int class = 0; class < classes && moves >= 0; class++)
+        {
+            uint64_t* target[4];    // up, down, left, right
+            for (int d = 0; d < 4; d++)
+            {
+                target[d] = moved + (first ? 1 + d : class) * words;
+            }
+            if (y + 1 < solver->rowTo[moves])
+            {
+                const uint64_t* below = LayerRow(solver, moves, class, y + 1);
+                for (int w = wfrom; w < wto; w++)
+                {
+                    target[0][w] |= below[w];
+                }
+            }
+            if (y - 1 >= solver->rowFrom[moves])
+            {
+                const uint64_t* above = LayerRow(solver, moves, class, y - 1);
+                for (int w = wfrom; w < wto; w++)
+                {
+                    target[1][w] |= above[w];
+                }
+            }
+            if (y >= solver->rowFrom[moves] && y < solver->rowTo[moves])
+            {
+                const uint64_t* row = LayerRow(solver, moves, class, y);
+                OrShiftedLeft(target[2], row, wfrom, wto, words);
+                OrShiftedRight(target[3], row, wfrom, wto);
+            }
+        }
+        for (int class = 0; class < classes; class++)
+        {
+            uint64_t* row = moved + class * words;
+            for (int w = wfrom; w < wto; w++)
+            {
+                row[w] &= mask[w];
+                anyMove |= row[w] != 0;
+            }
+        }
+        int anyWait = 0;
+        for (int class = 0; class < classes && y >= solver->rowFrom[waits] && y < solver->rowTo[waits]; class++)
+        {
+            const uint64_t* row = LayerRow(solver, waits, class, y);
+            for (int w = wfrom; w < wto; w++)
+            {
+                anyWait |= (row[w] & mask[w]) != 0;
+            }
+        }
+        if (!anyMove && !anyWait)
+        {
+            continue;
+        }
+
+        memset(unsafe, 0, words * sizeof(uint64_t));
+        OrRowOccupancy(solver, y, sim->cars->frame + t, unsafe);
+        memcpy(window, unsafe, words * sizeof(uint64_t));
+        for (int step = t - period + 1; step < t && anyMove; step++)
+        {
+            OrRowOccupancy(solver, y, sim->cars->frame + step, window);
+        }
+        int any = 0;
+        for (int class = 0; class < classes; class++)
+        {
+            uint64_t* row = LayerRow(solver, out, class, y);
+            const uint64_t* wait = anyWait ? LayerRow(solver, waits, class, y) : NULL;
+            for (int w = wfrom; w < wto; w++)
+            {
+                row[w] = (moved[class * words + w] & ~window[w]) | (wait ? wait[w] & mask[w] & ~unsafe[w] : 0);
+                any |= row[w] != 0;
+            }
+        }
+        if (any)
+        {
+            solver->rowFrom[out] = solver->rowFrom[out] < solver->rowTo[out] ? solver->rowFrom[out] : y;
+            solver->rowTo[out] = y + 1;
+        }
+    }
+}
+
+void Solve(SOLVER* solver, int key, SOLUTION* solution)
+{
+    SIM* sim = solver->sim;
+    OBJ* frog = sim->frog;
+    DEST* dest = sim->dest;
+    int period = solver->period;
+    int ring = period + 1;
+    memset(solution, 0, sizeof(SOLUTION));
+    solution->key = NO_KEY;
+    if (sim->result != RUNNING || sim->cfg->area->endless)
+    {
+        return;
+    }
+
+    // the frog waits for its cooldown first - wherever the cars are
+    int horizon = StepsLeft(sim);
+    int start = frog->moveFactor + sim->cfg->frog->moveFactor - sim->timer->frameNo;
+    start = start > 0 ? start : 0;
+    uint64_t* unsafe = solver->scratch;
+    for (int step = 1; step <= start && step < horizon; step++)
+    {
+        memset(unsafe, 0, solver->words * sizeof(uint64_t));
+        OrRowOccupancy(solver, frog->y, sim->cars->frame + step, unsafe);
+        if (TestBit(unsafe, frog->x))
+        {
+            return;
+        }
+    }
+
+    for (int slot = 0; slot < ring; slot++)
+    {
+        ClearLayer(solver, slot, SOLVER_CLASSES);
+    }
+    int classes = key ? SOLVER_CLASSES : 1;
+    LayerRow(solver, start % ring, 0, frog->y)[frog->x >> 6] |= 1ULL << (frog->x & 63);
+    solver->rowFrom[start % ring] = frog->y;
+    solver->rowTo[start % ring] = frog->y + 1;
+
+    static const int dx[4] = { 0, 0, -1, 1 };   // up, down, left, right
+    static const int dy[4] = { -1, 1, 0, 0 };
+    for (int step = start; step < horizon; step++)
+    {
+        int slot = step % ring;
+        for (int class = 0; class < classes; class++)
+        {
+            for (int y = solver->rowFrom[slot]; y < solver->rowTo[slot]; y++)
+            {
+                const uint64_t* row = LayerRow(solver, slot, class, y);
+                for (int w = 0; w < solver->words; w++)
+                {
+                    solution->states += __builtin_popcountll(row[w]);
+                }
+            }
+        }
+
+        // the destination is checked before the collision - a move onto it wins in the next step
+        for (int class = 0; class < classes; class++)
+        {
+            for (int d = 0; d < 4; d++)
+            {
+                int x = dest->x - dx[d];
+                int y = dest->y - dy[d];
+                if (x >= frog->xmin && x + frog->width <= frog->xmax && y >= solver->rowFrom[slot] && y < solver->rowTo[slot] &&
+                    TestBit(LayerRow(solver, slot, class, y), x))
+                {
+                    solution->found = 1;
+                    solution->steps = step + 1;
+                    solution->key = key ? ClassKey(sim, step == start ? 1 + d : class) : NO_KEY;
+                    return;
+                }
+            }
+        }
+
+        if (step + 1 >= horizon)
+        {
+            break;
+        }
+        ExpandStep(solver, step + 1, start, classes, key && step + 1 - period == start, horizon);
+        int alive = 0;
+        for (int past = step + 2 - period; past <= step + 1; past++)
+        {
+            alive |= past >= start && solver->rowFrom[past % ring] < solver->rowTo[past % ring];
+        }
+        if (!alive)
+        {
+            break;  // every frog has been hit
+        }
+    }
+}
+
+int AutopilotKey(SOLVER* solver)
+{
+    SIM* sim = solver->sim;
+    if (sim->timer->frameNo - sim->frog->moveFactor < sim->cfg->frog->moveFactor)
+    {
+        return NO_KEY;  // MoveFrog would not take a key yet
+    }
+    SOLUTION solution;
+    Solve(solver, 1, &solution);
+    return solution.key;
+}
+
+void FreeSolver(SOLVER* solver)
+{
+    for (int i = 0; i < (solver->sim->lanes->nLanes > 0 ? solver->sim->lanes->nLanes : 1); i++)
+    {
+        free(solver->laneX[i]);
+        free(solver->laneFrame[i]);
+    }
+    free(solver->laneX);
+    free(solver->laneFrame);
+    free(solver->layers);
+    free(solver->rowFrom);
+    free(solver->rowTo);
+    free(solver->scratch);
+    free(solver->hits);
+    free(solver);
+}
+
+
+// --- SOLVABILITY CHECK ---
+void RunSolveCheck(CFG* cfg, int games, uint64_t seed, SOLVE_STATS* stats)
+{
+    memset(stats, 0, sizeof(SOLVE_STATS));
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    ARENA* arena = InitArena(SimArenaSize(cfg));
+    for (int i = 0; i < games; i++)
+    {
+        SIM* sim = InitSim(cfg, sprites, DeriveSeed(seed, i), arena);
+        SOLVER* solver = InitSolver(sim);
+        SOLUTION solution;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Solve(solver, 0, &solution);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        stats->games++;
+        stats->states += solution.states;
+        stats->seconds += seconds;
+        stats->maxSeconds = seconds > stats->maxSeconds ? seconds : stats->maxSeconds;
+        if (solution.found)
+        {
+            stats->minSteps = stats->solvable == 0 || solution.steps < stats->minSteps ? solution.steps : stats->minSteps;
+            stats->maxSteps = solution.steps > stats->maxSteps ? solution.steps : stats->maxSteps;
+            stats->solvable++;
+            stats->steps += solution.steps;
+        }
+        FreeSolver(solver);
+        ResetArena(arena);
+    }
+    FreeArena(arena);
+    FreeSpriteAtlas(sprites);
+}
+
+void PrintSolveStats(SOLVE_STATS* stats, FILE* out)
+{
+    fprintf(out, "games: %d\n", stats->games);
+    fprintf(out, "solvable: %d (%.1f%%)\n", stats->solvable, stats->games ? 100.0 * stats->solvable / stats->games : 0.0);
+    if (stats->solvable > 0)
+    {
+        fprintf(out, "frames to finish: %.1f (min %d, max %d)\n", (double)stats->steps / stats->solvable, stats->minSteps, stats->maxSteps);
+    }
+    fprintf(out, "states: %.0f per game\n", stats->games ? (double)stats->states / stats->games : 0.0);
+    if (stats->games > 0)
+    {
+        fprintf(out, "solve time: %.3f ms mean, %.3f ms max\n", 1e3 * stats->seconds / stats->games, 1e3 * stats->maxSeconds);
+    }
+}
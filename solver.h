@@ -0,0 +1,66 @@
+// solver.h
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdio.h>
+#include "sim.h"
+
+#define SOLVER_CLASSES 5        // first actions a path can start with - wait, up, down, left, right
+#define SOLVER_CACHE_FRAMES 4096    // frames of car occupancy cached per lane - a ring over absolute frames
+#define SOLVER_HIT_WORDS 2      // words of a hit mask - frog and car width - 1 bits, sprites are at most 64 wide
+
+// Result of a search
+typedef struct {
+    int found;      // 1 if the destination can be reached before the time is over
+    int steps;      // StepSim calls until it is reached (the last one returns SUCCESS)
+    int key;        // key of a fastest path for the next step, NO_KEY to wait
+    long states;    // search states expanded
+} SOLUTION;
+
+// Path solver - breadth-first search over (x, y, step) in step order, so the first path found is a fastest one
+// The cars are deterministic (respawns included), so their future is known exactly up to the end of the time:
+// the search runs over absolute steps rather than a hyperperiod. A state is a frog that can move (cooldown passed),
+// a step is one bitset of x positions per row - visited states are the bits, states that cannot reach the destination
+// in the moves left are masked off (A* bound). Car occupancy is cached per lane and absolute frame across searches
+typedef struct {
+    SIM* sim;
+    int words;              // 64-bit words per row of x positions
+    int period;             // steps from a move to the next possible one - max(FROG_MOVE_FACTOR, 1)
+    int cacheFrames;
+    int** laneX;            // per lane, per cached frame: x of the lane's cars, NULL until needed
+    int** laneFrame;        // per lane: absolute frame of every cached row, -1 for none
+    uint64_t* layers;       // period + 1 steps of states (a ring), SOLVER_CLASSES x rows x words each
+    int* rowFrom;           // per step of the ring: rows [rowFrom, rowTo) may hold states
+    int* rowTo;
+    uint64_t* scratch;      // rows being built - SOLVER_CLASSES + 3 rows of words
+    uint64_t* hits;         // per car top row relative to the frog's (+ car height - 1): frog x hit by a car at x,
+                            // bit b for frog x = x - frog width + 1 + b - the sprite masks, SOLVER_HIT_WORDS words each
+} SOLVER;
+
+// Solvability of a series of games
+typedef struct {
+    int games;
+    int solvable;
+    long steps;             // of the solvable games, in total
+    int minSteps, maxSteps;
+    long states;
+    double seconds;         // spent searching
+    double maxSeconds;
+} SOLVE_STATS;
+
+// --- SOLVER FUNCTIONS ---
+// Solver for a game - valid while the game runs (the occupancy cache relies on its cars not being replaced)
+// The endless road is not solved, its lanes are replaced as it scrolls
+SOLVER* InitSolver(SIM* sim);
+// Fastest way to the destination from the current state - the key of the next step only if key is 1 (5x the work)
+void Solve(SOLVER* solver, int key, SOLUTION* solution);
+// Key for the next step of the game - NO_KEY while the frog cools down or when it cannot make it
+int AutopilotKey(SOLVER* solver);
+void FreeSolver(SOLVER* solver);
+
+// --- SOLVABILITY CHECK ---
+// Is the start of every game solvable, and how fast - game i is seeded with DeriveSeed(seed, i)
+void RunSolveCheck(CFG* cfg, int games, uint64_t seed, SOLVE_STATS* stats);
+void PrintSolveStats(SOLVE_STATS* stats, FILE* out);
+
+#endif // SOLVER_H
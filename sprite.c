@@ -0,0 +1,120 @@
+// sprite.c
+#include <stdlib.h>
+#include <string.h>
+#include "sprite.h"
+
+
+// --- SPRITE FUNCTIONS ---
+// Does the sprite have exactly this shape
+int SpriteMatches(SPRITE* sprite, char** shape, int width, int height)
+{
+    if (sprite->width != width || sprite->height != height)
+    {
+        return 0;
+    }
+    for (int y = 0; y < height; y++)
+    {
+        if (strncmp(sprite->cells + y * width, shape[y], width) != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Copy the shape and precompute its row lengths and opacity mask - spaces are transparent
+void LoadSprite(SPRITE* sprite, char** shape, int width, int height)
+{
+    sprite->width = width;
+    sprite->height = height;
+    sprite->cells = (char*)malloc(width * height * sizeof(char));
+    sprite->rowLength = (int*)malloc(height * sizeof(int));
+    sprite->opaque = (unsigned char*)malloc(width * height * sizeof(unsigned char));
+    sprite->mask = (uint64_t*)malloc(height * sizeof(uint64_t));
+    for (int y = 0; y < height; y++)
+    {
+        int length = (int)strlen(shape[y]);
+        sprite->rowLength[y] = 0;
+        sprite->mask[y] = 0;
+        for (int x = 0; x < width; x++)
+        {
+            char cell = x < length ? shape[y][x] : ' ';   // short rows are padded with spaces
+            sprite->cells[y * width + x] = cell;
+            sprite->opaque[y * width + x] = cell != ' ';
+            if (cell != ' ')
+            {
+                sprite->rowLength[y] = x + 1;
+                sprite->mask[y] |= x < 64 ? 1ULL << x : 0;
+            }
+        }
+    }
+}
+
+int SpritesOverlap(SPRITE* sprite, int x, int y, SPRITE* other, int otherX, int otherY)
+{
+    int top = y > otherY ? y : otherY;
+    int bottom = y + sprite->height < otherY + other->height ? y + sprite->height : otherY + other->height;
+    if (top >= bottom || otherX >= x + sprite->width || x >= otherX + other->width)
+    {
+        return 0;
+    }
+    int shift = otherX - x;     // column c of the other sprite is column c + shift of this one, |shift| < 64
+    for (int row = top; row < bottom; row++)
+    {
+        uint64_t bits = other->mask[row - otherY];
+        if (sprite->mask[row - y] & (shift >= 0 ? bits << shift : bits >> -shift))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// --- SPRITE ATLAS FUNCTIONS ---
+SPRITE_ATLAS* InitSpriteAtlas(CFG* cfg)
+{
+    SPRITE_ATLAS* atlas = (SPRITE_ATLAS*)malloc(sizeof(SPRITE_ATLAS));
+    atlas->count = 0;
+    atlas->capacity = 4;
+    atlas->sprites = (SPRITE*)malloc(atlas->capacity * sizeof(SPRITE));
+    atlas->frog = AddSprite(atlas, cfg->frog->shape, cfg->frog->width, cfg->frog->height);
+    atlas->car = AddSprite(atlas, cfg->cars->shape, cfg->cars->width, cfg->cars->height);
+    return atlas;
+}
+
+int AddSprite(SPRITE_ATLAS* atlas, char** shape, int width, int height)
+{
+    for (int i = 0; i < atlas->count; i++)
+    {
+        if (SpriteMatches(&atlas->sprites[i], shape, width, height))
+        {
+            return i;
+        }
+    }
+    if (atlas->count == atlas->capacity)
+    {
+        atlas->capacity *= 2;
+        atlas->sprites = (SPRITE*)realloc(atlas->sprites, atlas->capacity * sizeof(SPRITE));
+    }
+    LoadSprite(&atlas->sprites[atlas->count], shape, width, height);
+    return atlas->count++;
+}
+
+SPRITE* GetSprite(SPRITE_ATLAS* atlas, int id)
+{
+    return &atlas->sprites[id];
+}
+
+void FreeSpriteAtlas(SPRITE_ATLAS* atlas)
+{
+    for (int i = 0; i < atlas->count; i++)
+    {
+        free(atlas->sprites[i].cells);
+        free(atlas->sprites[i].rowLength);
+        free(atlas->sprites[i].opaque);
+        free(atlas->sprites[i].mask);
+    }
+    free(atlas->sprites);
+    free(atlas);
+}
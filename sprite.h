@@ -0,0 +1,36 @@
+// sprite.h
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdint.h>
+#include "cfg.h"
+
+// Sprite - a shape loaded once and shared by every object drawn with it
+typedef struct {
+    int width, height;
+    char* cells;            // height rows of width characters, not terminated
+    int* rowLength;         // characters up to the last opaque one in each row
+    unsigned char* opaque;  // 1 for the cells to draw, 0 for transparent spaces
+    uint64_t* mask;         // opaque cells of each row as bits, column x is bit x - shapes are at most CFG_MAX_SHAPE (64) wide
+} SPRITE;
+
+// Sprite atlas - interned sprites, objects keep the id of their sprite
+typedef struct {
+    SPRITE* sprites;
+    int count;
+    int capacity;
+    int frog;               // ids of the configured shapes
+    int car;
+} SPRITE_ATLAS;
+
+// --- SPRITE ATLAS FUNCTIONS ---
+// Atlas initializer - loads the frog and car shapes of the config
+SPRITE_ATLAS* InitSpriteAtlas(CFG* cfg);
+// Id of the sprite with the given shape, added to the atlas if it is not there yet
+int AddSprite(SPRITE_ATLAS* atlas, char** shape, int width, int height);
+SPRITE* GetSprite(SPRITE_ATLAS* atlas, int id);
+// Do the opaque cells of two sprites at the given positions overlap - box test first, then one AND per shared row
+int SpritesOverlap(SPRITE* sprite, int x, int y, SPRITE* other, int otherX, int otherY);
+void FreeSpriteAtlas(SPRITE_ATLAS* atlas);
+
+#endif // SPRITE_H
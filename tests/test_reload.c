@@ -0,0 +1,65 @@
+// test_reload.c - a config reloaded mid-game keeps the time played so far
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../sim.h"
+
+int failures = 0;
+
+void Check(int ok, const char* what, double got, double expected)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s - got %.3f, expected %.3f\n", what, got, expected);
+        failures++;
+    }
+}
+
+CFG* TestCfg(int frameTime)
+{
+    CFG* cfg = (CFG*)malloc(sizeof(CFG));
+    LoadCfgDefaults(cfg);
+    cfg->timing->frameTime = frameTime;
+    cfg->timing->initialTime = 20;
+    cfg->cars->nCars = 0;   // nothing to run into
+    return cfg;
+}
+
+// Play 10 s at 25 ms, reload with the given frame time, then play 5 s more
+void TestRetime(int frameTime)
+{
+    CFG* cfg = TestCfg(25);
+    CFG* reloaded = TestCfg(frameTime);
+    SPRITE_ATLAS* sprites = InitSpriteAtlas(cfg);
+    ARENA* arena = InitArena(SimArenaSize(cfg));
+    SIM* sim = InitSim(cfg, sprites, 1, arena);
+    for (int i = 0; i < 10000 / 25; i++)
+    {
+        StepSim(sim, NO_KEY);
+    }
+    double before = sim->timer->timeLeft;
+    ApplyCfg(sim, reloaded);
+    Check(sim->timer->timeLeft == before, "time left right after the reload", sim->timer->timeLeft, before);
+    GameResult result = StepSim(sim, NO_KEY);
+    Check(result == RUNNING, "the game still runs after one step", result, RUNNING);
+    double expected = before - frameTime / 1000.0;
+    Check(fabs(sim->timer->timeLeft - expected) < 1e-4, "one step after the reload", sim->timer->timeLeft, expected);
+    for (int i = 1; i < 5000 / frameTime; i++)
+    {
+        StepSim(sim, NO_KEY);
+    }
+    Check(fabs(sim->timer->timeLeft - (before - 5.0)) < 1e-4, "5 s after the reload", sim->timer->timeLeft, before - 5.0);
+    FreeArena(arena);
+    FreeSpriteAtlas(sprites);
+    FreeCfg(cfg);
+    FreeCfg(reloaded);
+}
+
+int main()
+{
+    TestRetime(50);     // slower frames - the game must not end at once
+    TestRetime(10);     // faster frames - no time is given back
+    TestRetime(25);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
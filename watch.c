@@ -0,0 +1,173 @@
+// watch.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "watch.h"
+
+
+// --- RELOADING ---
+// Parse the file into a new config - the errors go into the message instead of a terminal
+CFG_RELOAD* ReloadCfg(const char* filename)
+{
+    CFG_RELOAD* reload = (CFG_RELOAD*)malloc(sizeof(CFG_RELOAD));
+    reload->cfg = (CFG*)malloc(sizeof(CFG));
+    LoadCfgDefaults(reload->cfg);
+    char* errors = NULL;
+    size_t size = 0;
+    FILE* err = open_memstream(&errors, &size);
+    if (!err || LoadCfgFromFile(reload->cfg, filename, err) != 0)
+    {
+        FreeCfg(reload->cfg);
+        reload->cfg = NULL;
+    }
+    if (err)
+    {
+        fclose(err);
+    }
+    if (reload->cfg)
+    {
+        snprintf(reload->message, WATCH_MESSAGE_SIZE, "%s reloaded", filename);
+    }
+    else
+    {
+        size_t length = errors ? strcspn(errors, "\n") : 0;
+        snprintf(reload->message, WATCH_MESSAGE_SIZE, "%.*s", (int)length, errors ? errors : "");
+    }
+    free(errors);
+    return reload;
+}
+
+// Publish a reload - the one the game has not taken yet is dropped
+void PublishReload(CFG_WATCHER* watcher, CFG_RELOAD* reload)
+{
+    CFG_RELOAD* old = atomic_exchange_explicit(&watcher->pending, reload, memory_order_acq_rel);
+    if (old)
+    {
+        if (old->cfg)
+        {
+            FreeCfg(old->cfg);
+        }
+        free(old);
+    }
+    atomic_fetch_add_explicit(&watcher->reloads, 1, memory_order_relaxed);
+}
+
+// 1 if the events read concern the watched file
+int FileChanged(CFG_WATCHER* watcher, const char* buffer, ssize_t length)
+{
+    int changed = 0;
+    for (const char* p = buffer; p < buffer + length; )
+    {
+        const struct inotify_event* event = (const struct inotify_event*)p;
+        changed |= event->len > 0 && strcmp(event->name, watcher->name) == 0;
+        p += sizeof(struct inotify_event) + event->len;
+    }
+    return changed;
+}
+
+
+// --- WATCHER THREAD ---
+void* RunWatcher(void* arg)
+{
+    CFG_WATCHER* watcher = (CFG_WATCHER*)arg;
+    struct pollfd fds[2] = { { watcher->fd, POLLIN, 0 }, { watcher->wake[0], POLLIN, 0 } };
+    _Alignas(struct inotify_event) char buffer[4096];
+    while (1)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents)
+        {
+            break;  // stopped
+        }
+        ssize_t n = read(watcher->fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            {
+                continue;
+            }
+            break;
+        }
+        if (FileChanged(watcher, buffer, n))
+        {
+            PublishReload(watcher, ReloadCfg(watcher->filename));   // one parse for a burst of events read together
+        }
+    }
+    return NULL;
+}
+
+CFG_WATCHER* StartCfgWatcher(const char* filename)
+{
+    CFG_WATCHER* watcher = (CFG_WATCHER*)malloc(sizeof(CFG_WATCHER));
+    watcher->filename = filename;
+    const char* slash = strrchr(filename, '/');
+    watcher->name = strdup(slash ? slash + 1 : filename);
+    char* directory = slash ? strndup(filename, slash - filename + 1) : strdup(".");
+    atomic_init(&watcher->pending, NULL);
+    atomic_init(&watcher->reloads, 0);
+    watcher->fd = inotify_init1(IN_CLOEXEC);
+    int watched = watcher->fd >= 0 &&
+        inotify_add_watch(watcher->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) >= 0;  // not IN_CREATE - a new file is still empty then
+    free(directory);
+    if (!watched || pipe(watcher->wake) != 0)
+    {
+        if (watcher->fd >= 0)
+        {
+            close(watcher->fd);
+        }
+        free(watcher->name);
+        free(watcher);
+        return NULL;
+    }
+    if (pthread_create(&watcher->thread, NULL, RunWatcher, watcher) != 0)
+    {
+        close(watcher->wake[0]);
+        close(watcher->wake[1]);
+        close(watcher->fd);
+        free(watcher->name);
+        free(watcher);
+        return NULL;
+    }
+    return watcher;
+}
+
+CFG_RELOAD* TakeCfgReload(CFG_WATCHER* watcher)
+{
+    if (!atomic_load_explicit(&watcher->pending, memory_order_relaxed))
+    {
+        return NULL;    // the common case - no read-modify-write in every frame
+    }
+    return atomic_exchange_explicit(&watcher->pending, NULL, memory_order_acq_rel);
+}
+
+void StopCfgWatcher(CFG_WATCHER* watcher)
+{
+    char stop = 0;
+    while (write(watcher->wake[1], &stop, 1) < 0 && errno == EINTR);
+    pthread_join(watcher->thread, NULL);
+    CFG_RELOAD* reload = TakeCfgReload(watcher);
+    if (reload)
+    {
+        if (reload->cfg)
+        {
+            FreeCfg(reload->cfg);
+        }
+        free(reload);
+    }
+    close(watcher->wake[0]);
+    close(watcher->wake[1]);
+    close(watcher->fd);
+    free(watcher->name);
+    free(watcher);
+}
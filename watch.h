@@ -0,0 +1,38 @@
+// watch.h
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "cfg.h"
+
+#define WATCH_MESSAGE_SIZE 256
+
+// Outcome of a reload of the settings file
+typedef struct {
+    CFG* cfg;                           // defaults overridden by the file, NULL if it has errors
+    char message[WATCH_MESSAGE_SIZE];   // for the player - the first error if there is one
+} CFG_RELOAD;
+
+// Config watcher - a thread blocked in poll() on inotify, parsing the settings file whenever it has been written
+// (in place or replaced by a rename, as editors do). The directory is watched, so the file may come and go.
+// A reload is published with one atomic exchange and taken by the game loop at a frame boundary;
+// one the game has not taken yet is replaced by the newer one
+typedef struct {
+    const char* filename;
+    char* name;             // of the file within the watched directory
+    int fd;                 // inotify
+    int wake[2];            // pipe that stops the thread
+    pthread_t thread;
+    _Atomic(CFG_RELOAD*) pending;
+    _Atomic long reloads;   // files parsed so far
+} CFG_WATCHER;
+
+// --- WATCHER FUNCTIONS ---
+// Watch the settings file on a new thread - NULL if inotify or the thread are not available
+CFG_WATCHER* StartCfgWatcher(const char* filename);
+// Latest reload not taken yet, NULL if there is none - the caller owns it (and its config), free it with free()
+CFG_RELOAD* TakeCfgReload(CFG_WATCHER* watcher);
+void StopCfgWatcher(CFG_WATCHER* watcher);
+
+#endif // WATCH_H